@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// dispatchbench.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+// Measures the per-request cost of resolving a method name and invoking its
+// handler, comparing the previous std::map<std::string, std::function>
+// command map against the perfect-hash table in commands.cpp. Lookups are
+// timed over every method name. Full dispatch goes through getCommand and
+// Command::operator(), as the server does, and invokes the real
+// cmd_getchannels handler on both paths, since that handler touches neither
+// the server nor the vault.
+//
+
+#include "commands.h"
+
+#include <CoinDB/SynchedVault.h>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <chrono>
+#include <cstdlib>
+
+using namespace std;
+
+typedef function<json_spirit::Value(WebSocket::Server&, websocketpp::connection_hdl, CoinDB::SynchedVault&, const json_spirit::Array&)> std_cmd_t;
+
+template<typename F>
+double timePerRequest(const vector<string>& methods, unsigned long iterations, F dispatch)
+{
+    auto start = chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        for (auto& method: methods) { dispatch(method); }
+    }
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+    return (double)elapsed.count() / (double)(iterations * methods.size());
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+
+    vector<string> methods;
+    for (size_t i = 0; i < getCommandCount(); i++) { methods.push_back(getCommands()[i].name()); }
+    methods.push_back("nosuchmethod");
+
+    // cmd_getchannels never touches the server or the vault, so uninitialized
+    // storage stands in for them.
+    alignas(WebSocket::Server) static char serverStorage[sizeof(WebSocket::Server)];
+    alignas(CoinDB::SynchedVault) static char synchedVaultStorage[sizeof(CoinDB::SynchedVault)];
+    WebSocket::Server& server = *reinterpret_cast<WebSocket::Server*>(serverStorage);
+    CoinDB::SynchedVault& synchedVault = *reinterpret_cast<CoinDB::SynchedVault*>(synchedVaultStorage);
+    websocketpp::connection_hdl hdl;
+    json_spirit::Array params;
+
+    // Before: ordered map of type-erased handlers
+    map<string, std_cmd_t> commandMap;
+    for (auto& method: methods) { commandMap.insert(make_pair(method, std_cmd_t(&cmd_getchannels))); }
+    commandMap.erase("nosuchmethod");
+
+    size_t found = 0;
+    double mapLookupNs = timePerRequest(methods, iterations, [&](const string& method)
+    {
+        if (commandMap.find(method) != commandMap.end()) { found++; }
+    });
+
+    vector<string> getchannels(1, "getchannels");
+    double mapDispatchNs = timePerRequest(getchannels, iterations, [&](const string& method)
+    {
+        auto it = commandMap.find(method);
+        if (it != commandMap.end()) { it->second(server, hdl, synchedVault, params); }
+    });
+
+    // After: compile-time perfect hash with direct function pointer calls
+    double hashLookupNs = timePerRequest(methods, iterations, [&](const string& method)
+    {
+        if (getCommand(method)) { found++; }
+    });
+
+    double hashDispatchNs = timePerRequest(getchannels, iterations, [&](const string& method)
+    {
+        const Command* command = getCommand(method);
+        if (command) { (*command)(server, hdl, synchedVault, params); }
+    });
+
+    cout << "Methods:     " << methods.size() << endl;
+    cout << "Iterations:  " << iterations << endl;
+    cout << "Found:       " << found << endl;
+    cout << fixed << setprecision(1);
+    cout << "std::map:    " << mapLookupNs << " ns/lookup, " << mapDispatchNs << " ns/getchannels request" << endl;
+    cout << "perfecthash: " << hashLookupNs << " ns/lookup, " << hashDispatchNs << " ns/getchannels request" << endl;
+    return 0;
+}
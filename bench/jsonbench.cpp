@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// jsonbench.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+// Measures the cost of rendering a tx as JSON text, comparing getTxObject
+// followed by write_string against writing it directly with JsonWriter, for
+// txs with increasing numbers of inputs and outputs. The last case labels its
+// outputs with non-ASCII text, quotes and control characters to check the
+// writer escapes strings the way json_spirit does.
+//
+
+#include "jsonobjects.h"
+#include "jsonwriter.h"
+#include "coinparams.h"
+
+#include <CoinDB/Schema.h>
+#include <CoinQ/CoinQ_coinparams.h>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+
+using namespace CoinSocket;
+using namespace CoinDB;
+using namespace std;
+
+static shared_ptr<Tx> makeTx(size_t nInputs, size_t nOutputs, const string& label)
+{
+    txins_t txins;
+    for (size_t i = 0; i < nInputs; i++)
+    {
+        bytes_t outhash(32, (unsigned char)i);
+        bytes_t script(253, (unsigned char)(i * 7));
+        txins.push_back(make_shared<TxIn>(outhash, (uint32_t)i, script, 0xffffffff));
+    }
+
+    txouts_t txouts;
+    for (size_t i = 0; i < nOutputs; i++)
+    {
+        // Pay to script hash
+        bytes_t script;
+        script.push_back(0xa9);
+        script.push_back(0x14);
+        script.insert(script.end(), 20, (unsigned char)i);
+        script.push_back(0x87);
+        shared_ptr<TxOut> txout = make_shared<TxOut>(100000 + i, script);
+        txout->sending_label(label);
+        txouts.push_back(txout);
+    }
+
+    shared_ptr<Tx> tx = make_shared<Tx>();
+    tx->set(1, txins, txouts, 0, time(NULL), Tx::PROPAGATED);
+    return tx;
+}
+
+template<typename F>
+double timePerTx(unsigned long iterations, F render)
+{
+    size_t bytes = 0;
+    auto start = chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++) { bytes += render(); }
+    auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+    if (bytes == 0) { cerr << "Nothing rendered." << endl; }
+    return (double)elapsed.count() / 1000.0 / (double)iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+
+    CoinQ::NetworkSelector networkSelector;
+    networkSelector.select("bitcoin");
+    setCoinParams(networkSelector.getCoinParams());
+
+    cout << "Iterations:  " << iterations << endl;
+    cout << setw(8) << "txins" << setw(8) << "txouts" << setw(10) << "bytes" << setw(16) << "tree us/tx" << setw(16) << "writer us/tx" << setw(10) << "same" << endl;
+    cout << fixed << setprecision(1);
+
+    struct Case
+    {
+        size_t nInputs;
+        size_t nOutputs;
+        const char* label;
+    };
+
+    const Case cases[] =
+    {
+        { 1, 2, "" },
+        { 10, 2, "" },
+        { 100, 10, "" },
+        { 1000, 50, "" },
+        { 10, 2, "Caf\xc3\xa9 \xe2\x82\xbf \"tab\"\there\x01\x7f" }
+    };
+
+    for (auto& c: cases)
+    {
+        shared_ptr<Tx> tx = makeTx(c.nInputs, c.nOutputs, c.label);
+
+        // Before: build the json_spirit tree then walk it
+        string treeJson;
+        double treeUs = timePerTx(iterations, [&]()
+        {
+            treeJson = json_spirit::write_string<json_spirit::Value>(getTxObject(*tx, true));
+            return treeJson.size();
+        });
+
+        // After: append text directly into a reused buffer
+        JsonWriter writer;
+        double writerUs = timePerTx(iterations, [&]()
+        {
+            writer.clear();
+            writeTxJson(writer, *tx, true);
+            return writer.str().size();
+        });
+
+        cout << setw(8) << c.nInputs << setw(8) << c.nOutputs << setw(10) << writer.str().size()
+             << setw(16) << treeUs << setw(16) << writerUs << setw(10) << (treeJson == writer.str() ? "yes" : "no") << endl;
+    }
+    return 0;
+}
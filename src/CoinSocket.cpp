@@ -28,6 +28,22 @@
 #include "alerts.h"
 #include "commands.h"
 #include "events.h"
+#include "executor.h"
+#include "metrics.h"
+#include "jobs.h"
+#include "outbound.h"
+#include "ratelimit.h"
+#include "deadline.h"
+#include "idempotency.h"
+#include "coalescer.h"
+#include "dispatcher.h"
+#include "replay.h"
+#include "compression.h"
+#include "encoding.h"
+#include "finality.h"
+#include "addresscache.h"
+#include "txjsoncache.h"
+#include "vaultlock.h"
 
 #include <iostream>
 #include <signal.h>
@@ -46,7 +62,12 @@ using namespace CoinDB;
 using namespace std;
 
 // Globals
-command_map_t g_command_map;
+// Runs client requests, one strand per connection.
+CommandExecutor g_commandExecutor;
+
+// Long-running commands submitted with submitjob run here so they do not
+// hold up the command executor.
+CommandExecutor g_jobExecutor;
 
 bool g_bShutdown = false;
 bool g_bDisconnected = false;
@@ -88,12 +109,18 @@ void openCallback(Server& server, websocketpp::connection_hdl hdl)
 #else
     msg << "{\"event\":\"connected\", \"data\":{}}";
 #endif
-    server.send(hdl, msg.str());
+    getOutbound().send(hdl, msg.str());
 }
 
 void closeCallback(Server& server, websocketpp::connection_hdl hdl)
 {
     LOGGER(info) << "Client " << server.getRemoteEndpoint(hdl) << " disconnected as " << hdl.lock().get() << "." << endl;
+    unsubscribeAll(hdl);
+    getOutbound().removeConnection(hdl);
+    getRateLimiter().removeConnection(hdl);
+    removeRequestTimeout(hdl);
+    getCompressor().removeConnection(hdl);
+    removeConnectionEncoding(hdl);
 }
 
 #ifdef USE_TLS
@@ -124,38 +151,341 @@ Server::context_ptr tlsInit(const std::string& tlsCertificateFile, Server& serve
 #endif
 
 
-void requestCallback(Server& server, SynchedVault& synchedVault, const Server::client_request_t& req)
+json_spirit::Object getErrorObject(const exception& e)
+{
+    using namespace json_spirit;
+
+    Object error;
+    error.push_back(Pair("message", string(e.what())));
+    const stdutils::custom_error* ce = dynamic_cast<const stdutils::custom_error*>(&e);
+    if (ce && ce->has_code()) { error.push_back(Pair("code", ce->code())); }
+    return error;
+}
+
+// CBOR responses have the same shape as JSON-RPC ones, with raw bytes as
+// byte strings.
+payload_ptr makeCborResponse(const json_spirit::Value& result, const json_spirit::Value& error, const json_spirit::Value& id)
+{
+    using namespace json_spirit;
+
+    Object response;
+    response.push_back(Pair("result", result));
+    response.push_back(Pair("error", error));
+    response.push_back(Pair("id", id));
+    return makeCborPayload(response);
+}
+
+json_spirit::Value executeCommand(Server& server, websocketpp::connection_hdl hdl, SynchedVault& synchedVault, const Command& command, const json_spirit::Array& params)
+{
+    VaultLock lock(command.access());
+    CommandTimer timer(&command);
+    return command(server, hdl, synchedVault, params);
+}
+
+// Runs an array of {"method", "params", "id"} objects in a single pass,
+// taking the vault lock once for the whole batch. Each entry yields its own
+// {"result", "error", "id"} object so one failing command does not affect
+// the rest.
+json_spirit::Value executeBatch(Server& server, websocketpp::connection_hdl hdl, SynchedVault& synchedVault, const json_spirit::Array& requests)
+{
+    using namespace json_spirit;
+
+    if (requests.empty()) throw CommandInvalidParametersException();
+
+    static const Array noParams;
+    vector<const Command*> commands;
+    commands.reserve(requests.size());
+
+    Command::access_t access = Command::NO_VAULT;
+    for (auto& request: requests)
+    {
+        const Command* command = nullptr;
+        if (request.type() == obj_type)
+        {
+            const Value& method = find_value(request.get_obj(), "method");
+            if (method.type() == str_type)
+            {
+                command = getCommand(method.get_str());
+                if (command && command->access() > access) { access = command->access(); }
+            }
+        }
+        commands.push_back(command);
+    }
+
+    VaultLock lock(access, false);
+
+    Array results;
+    results.reserve(requests.size());
+    for (size_t i = 0; i < requests.size(); i++)
+    {
+        Value id;
+        Object response;
+        try
+        {
+            if (requests[i].type() != obj_type) throw CommandInvalidParametersException();
+
+            const Object& request = requests[i].get_obj();
+            id = find_value(request, "id");
+            if (!commands[i]) throw CommandInvalidMethodException();
+            checkDeadline();
+
+            const Value& params = find_value(request, "params");
+            if (!params.is_null() && params.type() != array_type) throw CommandInvalidParametersException();
+
+            CommandTimer timer(commands[i]);
+            Value result = (*commands[i])(server, hdl, synchedVault, params.is_null() ? noParams : params.get_array());
+            response.push_back(Pair("result", result));
+            response.push_back(Pair("error", Value()));
+        }
+        catch (const exception& e)
+        {
+            recordCommandError(commands[i], e);
+            response.push_back(Pair("result", Value()));
+            response.push_back(Pair("error", getErrorObject(e)));
+        }
+        response.push_back(Pair("id", id));
+        results.push_back(response);
+    }
+
+    return results;
+}
+
+// Queues a command as a job and returns its id immediately. The connection
+// then receives jobstarted, jobprogress and jobcompleted events for it.
+json_spirit::Value submitJob(Server& server, websocketpp::connection_hdl hdl, SynchedVault& synchedVault, const json_spirit::Array& params)
+{
+    using namespace json_spirit;
+
+    if (params.size() < 1 || params.size() > 2 || params[0].type() != str_type || (params.size() > 1 && params[1].type() != array_type))
+        throw CommandInvalidParametersException();
+
+    const Command* command = getCommand(params[0].get_str());
+    if (!command) throw CommandInvalidMethodException();
+
+    // Copied once and shared with the job rather than copied into it again.
+    static const Array noParams;
+    shared_ptr<const Array> jobParams = make_shared<const Array>(params.size() > 1 ? params[1].get_array() : noParams);
+
+    uint64_t jobId = newJobId();
+    CommandExecutor::task_t task = [&server, &synchedVault, hdl, command, jobParams, jobId]()
+    {
+        // Jobs have no deadline but are abandoned if the connection closes.
+        DeadlineScope deadlineScope(hdl, deadline_t::max());
+        JobScope job(server, hdl, jobId, command->name());
+        try
+        {
+            job.complete(executeCommand(server, hdl, synchedVault, *command, *jobParams));
+        }
+        catch (const exception& e)
+        {
+            recordCommandError(command, e);
+            job.fail(getErrorObject(e));
+        }
+    };
+
+    // Handed to the job executor from the connection's strand, which only
+    // runs it after this request has queued its response, so the client
+    // always has the job id before jobstarted.
+    g_commandExecutor.post(hdl, [hdl, task]() { g_jobExecutor.post(hdl, task); });
+
+    Object result;
+    result.push_back(Pair("jobid", jobId));
+    return result;
+}
+
+// Runs a mutating command at most once per client-supplied key. A retry with
+// the same key gets the stored result without touching the vault. Params are
+// [key, method, [params]]. Sets command once it is known so the caller
+// records any error against it.
+json_spirit::Value executeIdempotent(Server& server, websocketpp::connection_hdl hdl, SynchedVault& synchedVault, const json_spirit::Array& params, const Command*& command)
+{
+    using namespace json_spirit;
+
+    if (params.size() < 2 || params.size() > 3 || params[0].type() != str_type || params[1].type() != str_type || (params.size() > 2 && params[2].type() != array_type))
+        throw CommandInvalidParametersException();
+
+    const string& key = params[0].get_str();
+    if (key.empty()) throw CommandInvalidParametersException();
+
+    command = getCommand(params[1].get_str());
+    if (!command) throw CommandInvalidMethodException();
+
+    static const Array noParams;
+    const Array& commandParams = params.size() > 2 ? params[2].get_array() : noParams;
+
+    // Read-only commands are safe to retry anyway.
+    if (command->isReadOnly()) return executeCommand(server, hdl, synchedVault, *command, commandParams);
+
+    Value result;
+    if (getIdempotencyCache().get(key, command->name(), commandParams, result)) return result;
+
+    // Check again under the lock in case a concurrent retry got there first.
+    VaultLock lock(Command::MUTATING, false);
+    if (getIdempotencyCache().get(key, command->name(), commandParams, result)) return result;
+
+    {
+        CommandTimer timer(command);
+        result = (*command)(server, hdl, synchedVault, commandParams);
+    }
+
+    getIdempotencyCache().put(key, command->name(), commandParams, result);
+    return result;
+}
+
+// Channel sets in the configured windows stand for each of their channels.
+CoalesceWindows getChannelCoalesceWindows(const CoalesceWindows& windows)
+{
+    CoalesceWindows channelWindows;
+    for (auto& window: windows)
+    {
+        if (channelExists(window.first))
+        {
+            channelWindows[window.first] = window.second;
+            continue;
+        }
+
+        ChannelRange range = getChannelRange(window.first);
+        if (isChannelRangeEmpty(range)) throw ConfigInvalidCoalesceWindowException();
+        for (ChannelSets::iterator it = range.first; it != range.second; ++it)
+        {
+            if (!channelWindows.count(it->second)) { channelWindows[it->second] = window.second; }
+        }
+    }
+    return channelWindows;
+}
+
+// Rejects the request before it is queued if the executor is saturated or
+// the client has exceeded its rate limits. Batch entries and jobs are charged
+// to the methods they run.
+void admitRequest(CommandExecutor& executor, const Server::client_request_t& req)
 {
     using namespace json_spirit;
 
-    std::string remoteEndpoint = server.getRemoteEndpoint(req.first);
-    LOGGER(info) << "Client " << remoteEndpoint << " sent command " << req.second.getJson() << "." << std::endl;
+    uint32_t maxPending = getConfig().getMaxPendingCommands();
+    if (maxPending > 0 && executor.getPendingCount() >= maxPending) throw OperationServerBusyException();
+
+    const string& method = req.second.getMethod();
+    const Array& params = req.second.getParams();
+
+    vector<string> methods;
+    if (method == "batch")
+    {
+        for (auto& request: params)
+        {
+            if (request.type() != obj_type) continue;
+            const Value& entryMethod = find_value(request.get_obj(), "method");
+            if (entryMethod.type() == str_type) { methods.push_back(entryMethod.get_str()); }
+        }
+    }
+    else if (method == "submitjob" && !params.empty() && params[0].type() == str_type)
+    {
+        methods.push_back(params[0].get_str());
+    }
+    else if (method == "idempotent" && params.size() > 1 && params[1].type() == str_type)
+    {
+        methods.push_back(params[1].get_str());
+    }
+    else
+    {
+        methods.push_back(method);
+    }
+
+    if (!getRateLimiter().admit(req.first, methods)) throw CommandRateLimitedException();
+}
+
+void rejectRequest(Server& server, const Server::client_request_t& req, const stdutils::custom_error& e)
+{
+    LOGGER(info) << "Client " << server.getRemoteEndpoint(req.first) << " request rejected: " << e.what() << std::endl;
+
+    recordCommandError(getCommand(req.second.getMethod()), e);
+
+    JsonRpc::Response response;
+    response.setError(e, req.second.getId());
+
+    // Sent from the connection's strand so it cannot overtake responses to
+    // requests admitted before it, and in whichever encoding it has by then.
+    websocketpp::connection_hdl hdl = req.first;
+    string msg = response.getJson();
+    json_spirit::Value error = getErrorObject(e);
+    json_spirit::Value id = req.second.getId();
+    g_commandExecutor.post(hdl, [hdl, msg, error, id]()
+    {
+        if (hdl.expired()) return;
+        if (getConnectionEncoding(hdl) == ENCODING_CBOR)    { getOutbound().send(hdl, makeCborResponse(json_spirit::Value(), error, id), true); }
+        else                                                { getOutbound().send(hdl, msg); }
+    });
+}
+
+void requestCallback(Server& server, SynchedVault& synchedVault, const Server::client_request_t& req, deadline_t deadline)
+{
+    using namespace json_spirit;
 
     const string& method = req.second.getMethod();
     const Array& params = req.second.getParams();
     const Value& id = req.second.getId();
 
+    // Only the method and id - writing the whole request back out would cost
+    // as much as parsing it for large raw txs and batches.
+    if (getConfig().isLogged(LOG_INFO))
+    {
+        LOGGER(info) << "Client " << server.getRemoteEndpoint(req.first) << " sent command " << method << " id " << write_string<Value>(id) << " with " << params.size() << " params." << std::endl;
+    }
+
     JsonRpc::Response response;
+    Value result;
+    Value error;
+    const Command* command = nullptr;
+    DeadlineScope deadlineScope(req.first, deadline);
 
     try
     {
-        auto it = g_command_map.find(method);
-        if (it == g_command_map.end())
-            throw CommandInvalidMethodException();
+        // The request may have waited in the queue past its deadline or
+        // outlived its connection.
+        deadlineScope.check();
+
+        if (method == "batch")
+        {
+            result = executeBatch(server, req.first, synchedVault, params);
+        }
+        else if (method == "submitjob")
+        {
+            result = submitJob(server, req.first, synchedVault, params);
+        }
+        else if (method == "idempotent")
+        {
+            result = executeIdempotent(server, req.first, synchedVault, params, command);
+        }
+        else
+        {
+            command = getCommand(method);
+            if (!command)
+                throw CommandInvalidMethodException();
 
-        Value result = it->second(server, req.first, synchedVault, params);
-        response.setResult(result, id);
+            result = executeCommand(server, req.first, synchedVault, *command, params);
+        }
     }
     catch (const stdutils::custom_error& e)
     {
+        recordCommandError(command, e);
         response.setError(e, id);
+        error = getErrorObject(e);
     }
     catch (const exception& e)
     {
+        recordCommandError(command, e);
         response.setError(e, id);
+        error = getErrorObject(e);
     }
 
-    server.send(req.first, response);
+    if (req.first.expired()) return;
+    if (getConnectionEncoding(req.first) == ENCODING_CBOR)
+    {
+        getOutbound().send(req.first, makeCborResponse(result, error, id), true);
+        return;
+    }
+
+    if (error.is_null()) { response.setResult(result, id); }
+    getOutbound().send(req.first, response.getJson());
 }
 
 void trySendStartedAlert()
@@ -263,7 +593,6 @@ int main(int argc, char* argv[])
         LOGGER(info) << "Opening vault " << config.getDatabaseName() << endl;
         synchedVault.openVault(config.getDatabaseUser(), config.getDatabasePassword(), config.getDatabaseName(), false, SCHEMA_VERSION, string(), config.getMigrate());
 
-        initCommandMap(g_command_map);
         Server wsServer(config.getWebSocketPort(), config.getAllowedIps());
         wsServer.setValidateCallback(&validateCallback);
         wsServer.setOpenCallback(&openCallback);
@@ -274,9 +603,38 @@ int main(int argc, char* argv[])
             return tlsInit(config.getTlsCertificateFile(), server, hdl);
         });
 #endif
+
+        OverflowPolicy outQueuePolicy;
+        getOverflowPolicy(config.getOutQueuePolicy(), outQueuePolicy);
+        getOutbound().start(wsServer, config.getOutQueueMessages(), config.getOutQueueBytes(), outQueuePolicy);
+
+        g_commandExecutor.start(config.getCommandThreads());
+        g_jobExecutor.start(config.getJobThreads());
+        getRateLimiter().setLimits(config.getRateLimit(), config.getMethodRateLimits());
+        getIdempotencyCache().setMaxSize(config.getIdempotencyKeys());
+        setReplayCapacity(config.getReplayEvents(), config.getReplayRetain());
+        getCompressor().setThreshold(config.getCompressThreshold());
+        getFinalityTracker().setMaxSize(config.getFinalityTxs());
+        setMerkleBlockBatch(config.getMerkleBlockBatch(), config.getMerkleBlockBatchWindow());
+        getAddressCache().setMaxSize(config.getAddressCache());
+        getTxJsonCache().setMaxSize(config.getTxJsonCache());
         wsServer.setRequestCallback([&](Server& server, const Server::client_request_t& req)
         {
-            requestCallback(server, synchedVault, req);
+            try
+            {
+                admitRequest(g_commandExecutor, req);
+            }
+            catch (const stdutils::custom_error& e)
+            {
+                rejectRequest(server, req, e);
+                return;
+            }
+
+            deadline_t deadline = getRequestDeadline(req.first);
+            g_commandExecutor.post(req.first, [&server, &synchedVault, req, deadline]()
+            {
+                requestCallback(server, synchedVault, req, deadline);
+            });
         });
 
         try
@@ -295,19 +653,21 @@ int main(int argc, char* argv[])
             return 1;
         }
 
+        getEventDispatcher().start(wsServer, synchedVault);
+
         // SYNC STATUS CHANGE
-        synchedVault.subscribeStatusChanged([&](SynchedVault::status_t status) { sendStatusEvent(wsServer, synchedVault); });
+        synchedVault.subscribeStatusChanged([&](SynchedVault::status_t status) { getEventDispatcher().postStatus(); });
 
         addChannel("status");
         addChannelToSet("all", "status");
 
         // TX INSERTED 
-        synchedVault.subscribeTxInserted([&](shared_ptr<Tx> tx) { sendTxChannelEvent(INSERTED, wsServer, synchedVault, tx); });
+        synchedVault.subscribeTxInserted([&](shared_ptr<Tx> tx) { getEventDispatcher().postTx(INSERTED, tx); });
 
-        addChannel("txinserted");
-        addChannel("txinsertedjson");
-        addChannel("txinsertedraw");
-        addChannel("txinsertedserialized");
+        addTxChannel("txinserted");
+        addTxChannel("txinsertedjson");
+        addTxChannel("txinsertedraw");
+        addTxChannel("txinsertedserialized");
 
         addChannelToSet("tx",           "txinserted");
         addChannelToSet("txjson",       "txinsertedjson");
@@ -320,12 +680,16 @@ int main(int argc, char* argv[])
         addChannelToSet("all",          "txinsertedserialized");
 
         // TX UPDATED
-        synchedVault.subscribeTxUpdated([&](std::shared_ptr<Tx> tx) { sendTxChannelEvent(UPDATED, wsServer, synchedVault, tx); });
+        synchedVault.subscribeTxUpdated([&](std::shared_ptr<Tx> tx)
+        {
+            getTxJsonCache().invalidate(tx->unsigned_hash());
+            getEventDispatcher().postTx(UPDATED, tx);
+        });
 
-        addChannel("txupdated");
-        addChannel("txupdatedjson");
-        addChannel("txupdatedraw");
-        addChannel("txupdatedserialized");
+        addTxChannel("txupdated");
+        addTxChannel("txupdatedjson");
+        addTxChannel("txupdatedraw");
+        addTxChannel("txupdatedserialized");
 
         addChannelToSet("tx",           "txupdated");
         addChannelToSet("txjson",       "txupdatedjson");
@@ -338,12 +702,16 @@ int main(int argc, char* argv[])
         addChannelToSet("all",          "txupdatedserialized");
 
         // TX DELETED
-        synchedVault.subscribeTxDeleted([&](std::shared_ptr<Tx> tx) { sendTxChannelEvent(DELETED, wsServer, synchedVault, tx); });
+        synchedVault.subscribeTxDeleted([&](std::shared_ptr<Tx> tx)
+        {
+            getTxJsonCache().invalidate(tx->unsigned_hash());
+            getEventDispatcher().postTx(DELETED, tx);
+        });
 
-        addChannel("txdeleted");
-        addChannel("txdeletedjson");
-        addChannel("txdeletedraw");
-        addChannel("txdeletedserialized");
+        addTxChannel("txdeleted");
+        addTxChannel("txdeletedjson");
+        addTxChannel("txdeletedraw");
+        addTxChannel("txdeletedserialized");
 
         addChannelToSet("tx",           "txdeleted");
         addChannelToSet("txjson",       "txdeletedjson");
@@ -355,9 +723,9 @@ int main(int argc, char* argv[])
         addChannelToSet("all",          "txdeletedraw");
         addChannelToSet("all",          "txdeletedserialized");
 
-        addChannel("txapprovedjson");
-        addChannel("txcanceledjson");
-        addChannel("txrejectedjson");
+        addTxChannel("txapprovedjson");
+        addTxChannel("txcanceledjson");
+        addTxChannel("txrejectedjson");
 
         addChannelToSet("txjson",       "txapprovedjson");
         addChannelToSet("txjson",       "txcanceledjson");
@@ -370,17 +738,14 @@ int main(int argc, char* argv[])
         // MERKLE BLOCK INSERTED
         synchedVault.subscribeMerkleBlockInserted([&](std::shared_ptr<MerkleBlock> merkleblock)
         {
-            LOGGER(debug) << "Merkle block inserted: " << uchar_vector(merkleblock->blockheader()->hash()).getHex() << " Height: " << merkleblock->blockheader()->height() << endl;
-
             //if (synchedVault.getStatus() != SynchedVault::SYNCHED) return;
-
-            std::stringstream msg;
-            msg << "{\"event\":\"merkleblockinserted\", \"data\":" << merkleblock->toJson() << "}";
-            wsServer.sendChannel("merkleblockinserted", msg.str());
+            getEventDispatcher().postMerkleBlock(merkleblock);
         });
         addChannel("merkleblockinserted");
+        addChannel("merkleblocksinserted");
 
         addChannelToSet("all",          "merkleblockinserted");
+        addChannelToSet("all",          "merkleblocksinserted");
 
 
         // PEER DISCONNECTED
@@ -388,6 +753,7 @@ int main(int argc, char* argv[])
             g_bDisconnected = true;
         });
 
+        getEventCoalescer().start(getChannelCoalesceWindows(config.getCoalesceWindows()));
 
         if (config.getSync())
         {
@@ -406,6 +772,11 @@ int main(int argc, char* argv[])
             {
                 cout << "Interrupted." << endl;
                 LOGGER(info) << "Interrupted." << endl;
+                g_commandExecutor.stop();
+                g_jobExecutor.stop();
+                getEventDispatcher().stop();
+                getEventCoalescer().stop();
+                getOutbound().stop();
                 wsServer.stop();
                 return 0;
             }
@@ -452,6 +823,26 @@ int main(int argc, char* argv[])
         cout << "done." << endl;
         LOGGER(info) << "done." << endl;
 
+        cout << "Flushing events..." << flush;
+        LOGGER(info) << "Flushing events..." << endl;
+        getEventDispatcher().stop();
+        getEventCoalescer().stop();
+        cout << "done." << endl;
+        LOGGER(info) << "done." << endl;
+
+        cout << "Stopping command executor..." << flush;
+        LOGGER(info) << "Stopping command executor..." << endl;
+        g_commandExecutor.stop();
+        g_jobExecutor.stop();
+        cout << "done." << endl;
+        LOGGER(info) << "done." << endl;
+
+        cout << "Stopping outbound queues..." << flush;
+        LOGGER(info) << "Stopping outbound queues..." << endl;
+        getOutbound().stop();
+        cout << "done." << endl;
+        LOGGER(info) << "done." << endl;
+
         cout << "Stopping websocket server..." << flush;
         LOGGER(info) << "Stopping websocket server..." << endl;
         wsServer.stop();
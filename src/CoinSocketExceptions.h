@@ -29,15 +29,25 @@ enum ErrorCodes
     CONFIG_MISSING_SMTP_PASSWORD,
     CONFIG_MISSING_SMTP_URL,
     CONFIG_MISSING_SMTP_FROM,
+    CONFIG_INVALID_OUTQUEUE_POLICY,
+    CONFIG_INVALID_METHOD_RATE_LIMIT,
+    CONFIG_INVALID_COALESCE_WINDOW,
+    CONFIG_INVALID_OUTQUEUE_LIMIT,
+    CONFIG_INVALID_LOG_LEVEL,
 
     // Command  errors - these errors imply an error in a submitted command
     COMMAND_INVALID_METHOD = 1201,
     COMMAND_INVALID_PARAMETERS,
     COMMAND_INVALID_CHANNELS,
+    COMMAND_RATE_LIMITED,
+    COMMAND_IDEMPOTENCY_KEY_REUSED,
 
     // Operation errors - these errors imply an error in the execution of command
     OPERATION_TRANSACTION_NOT_INSERTED = 1301,
     OPERATION_TRANSACTION_NOT_DELETED,
+    OPERATION_SERVER_BUSY,
+    OPERATION_DEADLINE_EXCEEDED,
+    OPERATION_CANCELED,
 
     // Data format errors - these errors imply an error with the way parameter data is formatted
     DATA_FORMAT_INVALID_ADDRESS = 1401
@@ -111,6 +121,36 @@ public:
     explicit ConfigMissingSmtpFromException() : ConfigException("No smtpfrom specified.", CONFIG_MISSING_SMTP_FROM) { }
 };
 
+class ConfigInvalidOutQueuePolicyException : public ConfigException
+{
+public:
+    explicit ConfigInvalidOutQueuePolicyException() : ConfigException("Invalid outqueuepolicy.", CONFIG_INVALID_OUTQUEUE_POLICY) { }
+};
+
+class ConfigInvalidMethodRateLimitException : public ConfigException
+{
+public:
+    explicit ConfigInvalidMethodRateLimitException() : ConfigException("Invalid methodratelimit.", CONFIG_INVALID_METHOD_RATE_LIMIT) { }
+};
+
+class ConfigInvalidCoalesceWindowException : public ConfigException
+{
+public:
+    explicit ConfigInvalidCoalesceWindowException() : ConfigException("Invalid coalescewindow.", CONFIG_INVALID_COALESCE_WINDOW) { }
+};
+
+class ConfigInvalidOutQueueLimitException : public ConfigException
+{
+public:
+    explicit ConfigInvalidOutQueueLimitException() : ConfigException("Invalid outqueuemessages or outqueuebytes.", CONFIG_INVALID_OUTQUEUE_LIMIT) { }
+};
+
+class ConfigInvalidLogLevelException : public ConfigException
+{
+public:
+    explicit ConfigInvalidLogLevelException() : ConfigException("Invalid loglevel.", CONFIG_INVALID_LOG_LEVEL) { }
+};
+
 // COMMAND EXCEPTIONS
 class CommandException : public stdutils::custom_error
 {
@@ -139,6 +179,18 @@ public:
     explicit CommandInvalidChannelsException() : CommandException("Invalid subscription channels.", COMMAND_INVALID_CHANNELS) { }
 };
 
+class CommandRateLimitedException : public CommandException
+{
+public:
+    explicit CommandRateLimitedException() : CommandException("Rate limit exceeded.", COMMAND_RATE_LIMITED) { }
+};
+
+class CommandIdempotencyKeyReusedException : public CommandException
+{
+public:
+    explicit CommandIdempotencyKeyReusedException() : CommandException("Idempotency key already used for a different request.", COMMAND_IDEMPOTENCY_KEY_REUSED) { }
+};
+
 // OPERATION EXCEPTIONS
 class OperationException : public stdutils::custom_error
 {
@@ -161,6 +213,24 @@ public:
     explicit OperationTransactionNotDeletedException() : OperationException("Transaction not deleted.", OPERATION_TRANSACTION_NOT_DELETED) { }
 };
 
+class OperationServerBusyException : public OperationException
+{
+public:
+    explicit OperationServerBusyException() : OperationException("Server busy.", OPERATION_SERVER_BUSY) { }
+};
+
+class OperationDeadlineExceededException : public OperationException
+{
+public:
+    explicit OperationDeadlineExceededException() : OperationException("Request deadline exceeded.", OPERATION_DEADLINE_EXCEEDED) { }
+};
+
+class OperationCanceledException : public OperationException
+{
+public:
+    explicit OperationCanceledException() : OperationException("Request canceled.", OPERATION_CANCELED) { }
+};
+
 // DATA FORMAT EXCEPTIONS
 class DataFormatException : public stdutils::custom_error
 {
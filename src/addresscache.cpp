@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// addresscache.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "addresscache.h"
+#include "coinparams.h"
+
+#include <CoinQ/CoinQ_script.h>
+
+#include <functional>
+
+using namespace CoinSocket;
+using namespace json_spirit;
+using namespace std;
+
+void AddressCache::setMaxSize(size_t maxSize)
+{
+    m_maxShardSize = (maxSize + SHARDS - 1) / SHARDS;
+
+    for (auto& shard: m_shards)
+    {
+        lock_guard<mutex> lock(shard.mutex);
+        while (shard.entries.size() > m_maxShardSize)
+        {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+    }
+}
+
+string AddressCache::getAddress(const bytes_t& script)
+{
+    size_t maxShardSize = m_maxShardSize;
+    if (maxShardSize == 0) return CoinQ::Script::getAddressForTxOutScript(script, getCoinParams().address_versions());
+
+    string key(script.begin(), script.end());
+    Shard& shard = m_shards[hash<string>()(key) % SHARDS];
+
+    {
+        lock_guard<mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end())
+        {
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            m_hits++;
+            return it->second->second;
+        }
+    }
+
+    // Rendered outside the lock. A concurrent miss on the same script just
+    // renders it twice.
+    m_misses++;
+    string address = CoinQ::Script::getAddressForTxOutScript(script, getCoinParams().address_versions());
+
+    lock_guard<mutex> lock(shard.mutex);
+    if (shard.index.count(key)) return address;
+
+    shard.entries.push_front(make_pair(key, address));
+    shard.index[key] = shard.entries.begin();
+    while (shard.entries.size() > maxShardSize)
+    {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+    return address;
+}
+
+Object AddressCache::getMetricsObject()
+{
+    size_t size = 0;
+    for (auto& shard: m_shards)
+    {
+        lock_guard<mutex> lock(shard.mutex);
+        size += shard.entries.size();
+    }
+
+    uint64_t hits = m_hits;
+    uint64_t misses = m_misses;
+
+    Object result;
+    result.push_back(Pair("size", (uint64_t)size));
+    result.push_back(Pair("hits", hits));
+    result.push_back(Pair("misses", misses));
+    result.push_back(Pair("hitrate", hits + misses ? (double)hits / (double)(hits + misses) : 0.0));
+    return result;
+}
+
+AddressCache& CoinSocket::getAddressCache()
+{
+    static AddressCache addressCache;
+    return addressCache;
+}
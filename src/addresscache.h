@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// addresscache.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <stdutils/uchar_vector.h>
+#include <json_spirit/json_spirit_value.h>
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Addresses rendered from txout scripts, so the hash160 and base58check
+// encoding is done once per script rather than on every render. Split into
+// shards with their own locks and least recently used eviction so concurrent
+// renders rarely contend.
+class AddressCache
+{
+public:
+    AddressCache() : m_maxShardSize(0), m_hits(0), m_misses(0) { }
+
+    // Zero disables caching.
+    void setMaxSize(size_t maxSize);
+
+    // Uses the address versions of the current coin parameters.
+    std::string getAddress(const bytes_t& script);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    enum { SHARDS = 16 };
+
+    struct Shard
+    {
+        typedef std::list<std::pair<std::string, std::string>> entry_list_t;
+
+        std::mutex mutex;
+        entry_list_t entries;
+        std::unordered_map<std::string, entry_list_t::iterator> index;
+    };
+
+    Shard m_shards[SHARDS];
+    std::atomic<size_t> m_maxShardSize;
+    std::atomic<uint64_t> m_hits;
+    std::atomic<uint64_t> m_misses;
+};
+
+AddressCache& getAddressCache();
+
+}
@@ -12,11 +12,20 @@
 
 #include "channels.h"
 
+#include <mutex>
+#include <chrono>
+
 using namespace CoinSocket;
 
 static Channels    g_channels;
+static Channels    g_txChannels;
 static ChannelSets g_channelSets;
 
+static std::mutex  g_subscriptionMutex;
+static std::map<std::string, Subscribers> g_subscriptions;
+static std::chrono::seconds g_retainWindow(0);
+static std::map<std::string, std::chrono::steady_clock::time_point> g_retainedChannels;
+
 const Channels& CoinSocket::getChannels()
 {
     return g_channels;
@@ -27,6 +36,17 @@ void CoinSocket::addChannel(const std::string& channel)
     g_channels.insert(channel);
 }
 
+void CoinSocket::addTxChannel(const std::string& channel)
+{
+    g_channels.insert(channel);
+    g_txChannels.insert(channel);
+}
+
+bool CoinSocket::isTxChannel(const std::string& channel)
+{
+    return g_txChannels.count(channel);
+}
+
 bool CoinSocket::channelExists(const std::string& channel)
 {
     return g_channels.count(channel);
@@ -54,3 +74,111 @@ bool CoinSocket::isChannelRangeEmpty(const ChannelRange& range)
     return (range.first == range.second);
 }
 
+
+// Must be called with g_subscriptionMutex held. Keeps the channel rendered
+// for a while after its last subscriber leaves so the subscriber can resume.
+static void retainChannel(const std::string& channel)
+{
+    if (g_retainWindow.count() == 0) return;
+
+    g_retainedChannels[channel] = std::chrono::steady_clock::now() + g_retainWindow;
+}
+
+void CoinSocket::subscribe(websocketpp::connection_hdl hdl, const std::string& channel, filter_ptr filter)
+{
+    // A command can still be running for a connection that has since closed.
+    if (hdl.expired()) return;
+
+    std::lock_guard<std::mutex> lock(g_subscriptionMutex);
+    g_subscriptions[channel][hdl] = isTxChannel(channel) ? filter : filter_ptr();
+    g_retainedChannels.erase(channel);
+}
+
+void CoinSocket::unsubscribe(websocketpp::connection_hdl hdl, const std::string& channel)
+{
+    std::lock_guard<std::mutex> lock(g_subscriptionMutex);
+    auto it = g_subscriptions.find(channel);
+    if (it == g_subscriptions.end()) return;
+
+    it->second.erase(hdl);
+    if (it->second.empty())
+    {
+        retainChannel(channel);
+        g_subscriptions.erase(it);
+    }
+}
+
+void CoinSocket::unsubscribeAll(websocketpp::connection_hdl hdl)
+{
+    std::lock_guard<std::mutex> lock(g_subscriptionMutex);
+    for (auto it = g_subscriptions.begin(); it != g_subscriptions.end();)
+    {
+        it->second.erase(hdl);
+        if (it->second.empty())
+        {
+            retainChannel(it->first);
+            g_subscriptions.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+Subscribers CoinSocket::getSubscribers(const std::string& channel)
+{
+    std::lock_guard<std::mutex> lock(g_subscriptionMutex);
+    auto it = g_subscriptions.find(channel);
+    if (it == g_subscriptions.end()) return Subscribers();
+
+    // Connections that closed without being unsubscribed are dropped here.
+    Subscribers& subscribers = it->second;
+    for (auto subscriber = subscribers.begin(); subscriber != subscribers.end();)
+    {
+        if (subscriber->first.expired())    { subscribers.erase(subscriber++); }
+        else                                { ++subscriber; }
+    }
+
+    if (subscribers.empty())
+    {
+        retainChannel(channel);
+        g_subscriptions.erase(it);
+        return Subscribers();
+    }
+
+    return subscribers;
+}
+
+bool CoinSocket::hasSubscriptionFilters(const std::string& channel)
+{
+    std::lock_guard<std::mutex> lock(g_subscriptionMutex);
+    auto it = g_subscriptions.find(channel);
+    if (it == g_subscriptions.end()) return false;
+
+    for (auto& subscriber: it->second)
+    {
+        if (subscriber.second) return true;
+    }
+    return false;
+}
+
+bool CoinSocket::hasSubscribers(const std::string& channel)
+{
+    std::lock_guard<std::mutex> lock(g_subscriptionMutex);
+    if (g_subscriptions.count(channel) > 0) return true;
+
+    auto it = g_retainedChannels.find(channel);
+    if (it == g_retainedChannels.end()) return false;
+    if (it->second > std::chrono::steady_clock::now()) return true;
+
+    g_retainedChannels.erase(it);
+    return false;
+}
+
+void CoinSocket::setRetainChannels(uint32_t seconds)
+{
+    std::lock_guard<std::mutex> lock(g_subscriptionMutex);
+    g_retainWindow = std::chrono::seconds(seconds);
+    if (seconds == 0) { g_retainedChannels.clear(); }
+}
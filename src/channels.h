@@ -12,9 +12,15 @@
 
 #pragma once
 
+#include "filter.h"
+
+#include <WebSocketAPI/Server.h>
+
 #include <set>
 #include <string>
 #include <map>
+#include <memory>
+#include <cstdint>
 
 namespace CoinSocket
 {
@@ -23,9 +29,13 @@ typedef std::set<std::string> Channels;
 typedef std::multimap<std::string, std::string> ChannelSets;
 typedef std::pair<std::string, std::string> ChannelSetItem;
 typedef std::pair<ChannelSets::iterator, ChannelSets::iterator> ChannelRange;
+typedef std::map<websocketpp::connection_hdl, filter_ptr, std::owner_less<websocketpp::connection_hdl>> Subscribers;
 
 const Channels&     getChannels();
 void                addChannel(const std::string& channel);
+// A channel whose events are about txs and carry their attributes.
+void                addTxChannel(const std::string& channel);
+bool                isTxChannel(const std::string& channel);
 bool                channelExists(const std::string& channel);
 
 const ChannelSets&  getChannelSets();
@@ -33,4 +43,18 @@ void                addChannelToSet(const std::string& channelSet, const std::st
 ChannelRange        getChannelRange(const std::string& channelSet);
 bool                isChannelRangeEmpty(const ChannelRange& range);
 
+// Subscriptions. A filter only applies on tx channels; other channels are
+// subscribed to unfiltered.
+void                subscribe(websocketpp::connection_hdl hdl, const std::string& channel, filter_ptr filter = filter_ptr());
+void                unsubscribe(websocketpp::connection_hdl hdl, const std::string& channel);
+void                unsubscribeAll(websocketpp::connection_hdl hdl);
+Subscribers         getSubscribers(const std::string& channel);
+bool                hasSubscriptionFilters(const std::string& channel);
+
+// True if the channel has subscribers or lost its last one within the
+// retain window. Events are only rendered for such channels.
+bool                hasSubscribers(const std::string& channel);
+// Zero stops retaining channels.
+void                setRetainChannels(uint32_t seconds);
+
 }
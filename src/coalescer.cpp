@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// coalescer.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "coalescer.h"
+
+#include <logger/logger.h>
+
+#include <vector>
+#include <cstdlib>
+
+using namespace CoinSocket;
+using namespace json_spirit;
+using namespace std;
+
+static EventCoalescer g_eventCoalescer;
+
+EventCoalescer& CoinSocket::getEventCoalescer()
+{
+    return g_eventCoalescer;
+}
+
+bool CoinSocket::getCoalesceWindow(const string& str, string& channel, uint32_t& window)
+{
+    size_t pos = str.find(':');
+    if (pos == string::npos || pos == 0 || pos + 1 == str.size()) return false;
+
+    char* end;
+    unsigned long value = strtoul(str.c_str() + pos + 1, &end, 10);
+    if (*end != '\0' || value == 0 || value > UINT32_MAX) return false;
+
+    channel = str.substr(0, pos);
+    window = (uint32_t)value;
+    return true;
+}
+
+void EventCoalescer::start(const CoalesceWindows& windows)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_windows = windows;
+    m_bRunning = true;
+}
+
+void EventCoalescer::stop()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_bRunning = false;
+}
+
+bool EventCoalescer::defer(const string& channel, const string& key, send_t send)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_bRunning) return false;
+
+    auto windowIt = m_windows.find(channel);
+    if (windowIt == m_windows.end()) return false;
+
+    m_deferred++;
+    channel_pending_t& channels = m_pending[key];
+    auto it = channels.find(channel);
+    if (it != channels.end())
+    {
+        // Keep the original due time so a steady stream of updates cannot
+        // hold an event back forever.
+        it->second.send = send;
+        m_coalesced++;
+        return true;
+    }
+
+    Pending pending;
+    pending.send = send;
+    pending.due = chrono::steady_clock::now() + chrono::milliseconds(windowIt->second);
+    channels[channel] = pending;
+    m_pendingCount++;
+
+    m_schedule.insert(make_pair(pending.due, pending_key_t(key, channel)));
+    return true;
+}
+
+void EventCoalescer::cancel(const string& key)
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_pending.find(key);
+    if (it == m_pending.end()) return;
+
+    // Their schedule entries are skipped when they come due.
+    m_pendingCount -= it->second.size();
+    m_pending.erase(it);
+}
+
+EventCoalescer::time_point_t EventCoalescer::flush(bool bForce)
+{
+    vector<send_t> sends;
+    time_point_t next = time_point_t::max();
+    {
+        lock_guard<mutex> lock(m_mutex);
+        time_point_t now = chrono::steady_clock::now();
+        while (!m_schedule.empty())
+        {
+            auto item = m_schedule.begin();
+            if (!bForce && item->first > now)
+            {
+                next = item->first;
+                break;
+            }
+
+            pending_key_t pendingKey = item->second;
+            time_point_t due = item->first;
+            m_schedule.erase(item);
+
+            // Canceled, or replaced by a newer window for the same key.
+            auto keyIt = m_pending.find(pendingKey.first);
+            if (keyIt == m_pending.end()) continue;
+            auto it = keyIt->second.find(pendingKey.second);
+            if (it == keyIt->second.end() || it->second.due != due) continue;
+
+            sends.push_back(it->second.send);
+            keyIt->second.erase(it);
+            if (keyIt->second.empty()) { m_pending.erase(keyIt); }
+            m_pendingCount--;
+        }
+    }
+
+    for (auto& send: sends)
+    {
+        try
+        {
+            send();
+        }
+        catch (const exception& e)
+        {
+            LOGGER(error) << "EventCoalescer send error: " << e.what() << endl;
+        }
+    }
+
+    return next;
+}
+
+Object EventCoalescer::getMetricsObject()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Object result;
+    result.push_back(Pair("pending", (uint64_t)m_pendingCount));
+    result.push_back(Pair("deferred", m_deferred));
+    result.push_back(Pair("coalesced", m_coalesced));
+    return result;
+}
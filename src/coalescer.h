@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// coalescer.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <json_spirit/json_spirit_value.h>
+
+#include <string>
+#include <map>
+#include <functional>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Coalescing window in milliseconds for each channel.
+typedef std::map<std::string, uint32_t> CoalesceWindows;
+
+// Parses channel:milliseconds.
+bool getCoalesceWindow(const std::string& str, std::string& channel, uint32_t& window);
+
+// Holds back events on channels with a coalescing window. Events for the
+// same channel and key that arrive within the window replace each other, so
+// only the latest is sent when the window closes. The event dispatcher does
+// all the deferring, canceling and flushing on its own thread, so held events
+// go out in order with everything else it publishes.
+class EventCoalescer
+{
+public:
+    typedef std::function<void()> send_t;
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    EventCoalescer() : m_bRunning(false), m_pendingCount(0), m_deferred(0), m_coalesced(0) { }
+
+    void start(const CoalesceWindows& windows);
+
+    // Stops deferring. Whatever is still pending is left to the final flush.
+    void stop();
+
+    // Returns false if the channel has no window, in which case the caller
+    // should send the event right away.
+    bool defer(const std::string& channel, const std::string& key, send_t send);
+
+    // Discards pending events for the key on every channel.
+    void cancel(const std::string& key);
+
+    // Sends the events whose window has closed, or all of them if forced.
+    // Returns when the next window closes, or time_point_t::max() if none is
+    // pending.
+    time_point_t flush(bool bForce = false);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    // Key and channel.
+    typedef std::pair<std::string, std::string> pending_key_t;
+
+    struct Pending
+    {
+        send_t send;
+        time_point_t due;
+    };
+
+    // Channels with a pending event, by key.
+    typedef std::map<std::string, Pending> channel_pending_t;
+
+    std::mutex m_mutex;
+    bool m_bRunning;
+
+    CoalesceWindows m_windows;
+    std::map<std::string, channel_pending_t> m_pending;
+    std::multimap<time_point_t, pending_key_t> m_schedule;
+    size_t m_pendingCount;
+
+    uint64_t m_deferred;
+    uint64_t m_coalesced;
+};
+
+EventCoalescer& getEventCoalescer();
+
+}
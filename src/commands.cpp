@@ -18,6 +18,22 @@
 #include "coinparams.h"
 #include "channels.h"
 #include "jsonobjects.h"
+#include "metrics.h"
+#include "jobs.h"
+#include "outbound.h"
+#include "ratelimit.h"
+#include "deadline.h"
+#include "idempotency.h"
+#include "coalescer.h"
+#include "dispatcher.h"
+#include "replay.h"
+#include "compression.h"
+#include "encoding.h"
+#include "finality.h"
+#include "hex.h"
+#include "addresscache.h"
+#include "txjsoncache.h"
+#include "vaultlock.h"
 
 #include <CoinQ/CoinQ_script.h>
 #include <CoinCore/Base58Check.h>
@@ -50,6 +66,14 @@ std::string getAddressFromScript(const bytes_t& script, const unsigned char base
         return "N/A";
 }
 
+// Hashes and raw txs passed as hex
+static bytes_t getHexParam(const Value& param)
+{
+    bytes_t bytes;
+    if (!hexToBytes(param.get_str(), bytes)) throw CommandInvalidParametersException();
+    return bytes;
+}
+
 // Globals
 mutex g_txSubmissionMutex;
 
@@ -62,9 +86,22 @@ Value cmd_subscribe(Server& server, websocketpp::connection_hdl hdl, SynchedVaul
 {
     using namespace json_spirit;
 
+    // A trailing integer asks for every event after that sequence number.
+    size_t nChannels = params.size();
+    bool bResume = nChannels > 0 && params.back().type() == int_type;
+    if (bResume) { nChannels--; }
+
+    // An object among the channels filters tx events on all of them.
+    filter_ptr filter;
     Channels subscriptions;
-    for (auto& param: params)
+    for (size_t i = 0; i < nChannels; i++)
     {
+        const Value& param = params[i];
+        if (param.type() == obj_type && !filter)
+        {
+            filter = std::make_shared<SubscriptionFilter>(param.get_obj());
+            continue;
+        }
         if (param.type() != str_type) throw CommandInvalidParametersException();
         std::string channel = param.get_str();
         if (channelExists(channel))
@@ -79,8 +116,17 @@ Value cmd_subscribe(Server& server, websocketpp::connection_hdl hdl, SynchedVaul
         }
     }
 
-    for (auto& channel: subscriptions) { server.addToChannel(channel, hdl); }
-    return Value("success");
+    if (!bResume)
+    {
+        for (auto& channel: subscriptions) { CoinSocket::subscribe(hdl, channel, filter); }
+        return Value("success");
+    }
+
+    // If the events are no longer held the client must fall back to synctxs.
+    Object result;
+    result.push_back(Pair("resumed", subscribeFromSequence(hdl, subscriptions, params.back().get_uint64(), filter)));
+    result.push_back(Pair("seq", getLastSequence()));
+    return result;
 }
 
 Value cmd_unsubscribe(Server& server, websocketpp::connection_hdl hdl, SynchedVault& /*synchedVault*/, const Array& params)
@@ -89,7 +135,7 @@ Value cmd_unsubscribe(Server& server, websocketpp::connection_hdl hdl, SynchedVa
 
     if (params.size() == 0)
     {
-        server.removeFromAllChannels(hdl);
+        unsubscribeAll(hdl);
         return Value("success");
     }
 
@@ -110,7 +156,7 @@ Value cmd_unsubscribe(Server& server, websocketpp::connection_hdl hdl, SynchedVa
         }
     }
 
-    for (auto& channel: subscriptions) { server.removeFromChannel(channel, hdl); }
+    for (auto& channel: subscriptions) { CoinSocket::unsubscribe(hdl, channel); }
     return Value("success");
 }
 
@@ -172,6 +218,58 @@ Value cmd_exportvaulttofile(Server& /*server*/, websocketpp::connection_hdl /*hd
     return Value("success");
 }
 
+Value cmd_getmetrics(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, SynchedVault& /*synchedVault*/, const Array& params)
+{
+    if (params.size() != 0) throw CommandInvalidParametersException();
+
+    Object result = getMetricsObject();
+    result.push_back(Pair("outbound", getOutbound().getMetricsObject()));
+    result.push_back(Pair("ratelimited", getRateLimiter().getLimitedCount()));
+    result.push_back(Pair("idempotency", getIdempotencyCache().getMetricsObject()));
+    result.push_back(Pair("coalescer", getEventCoalescer().getMetricsObject()));
+    result.push_back(Pair("events", getEventDispatcher().getMetricsObject()));
+    result.push_back(Pair("replay", getReplayMetricsObject()));
+    result.push_back(Pair("compression", getCompressor().getMetricsObject()));
+    result.push_back(Pair("finality", getFinalityTracker().getMetricsObject()));
+    result.push_back(Pair("addresscache", getAddressCache().getMetricsObject()));
+    result.push_back(Pair("txjsoncache", getTxJsonCache().getMetricsObject()));
+    return result;
+}
+
+// Sets the timeout in milliseconds for subsequent requests on this connection.
+// Zero disables it.
+Value cmd_settimeout(Server& /*server*/, websocketpp::connection_hdl hdl, SynchedVault& /*synchedVault*/, const Array& params)
+{
+    if (params.size() != 1 || params[0].type() != int_type) throw CommandInvalidParametersException();
+
+    setRequestTimeout(hdl, (uint32_t)params[0].get_uint64());
+    return Value("success");
+}
+
+// Selects "cbor" or "json" for subsequent tx events and command results on
+// this connection.
+Value cmd_setencoding(Server& /*server*/, websocketpp::connection_hdl hdl, SynchedVault& /*synchedVault*/, const Array& params)
+{
+    if (params.size() != 1 || params[0].type() != str_type) throw CommandInvalidParametersException();
+
+    Encoding encoding;
+    if (!getEncoding(params[0].get_str(), encoding)) throw CommandInvalidParametersException();
+    setConnectionEncoding(hdl, encoding);
+    return Value("success");
+}
+
+// Selects "deflate" or "none" for subsequent messages to this connection.
+Value cmd_setcompression(Server& /*server*/, websocketpp::connection_hdl hdl, SynchedVault& /*synchedVault*/, const Array& params)
+{
+    if (params.size() != 1 || params[0].type() != str_type) throw CommandInvalidParametersException();
+
+    const std::string& compression = params[0].get_str();
+    if      (compression == "deflate")  { getCompressor().setEnabled(hdl, true); }
+    else if (compression == "none")     { getCompressor().setEnabled(hdl, false); }
+    else                                { throw CommandInvalidParametersException(); }
+    return Value("success");
+}
+
 // Keychain operations
 Value cmd_newkeychain(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, SynchedVault& synchedVault, const Array& params)
 {
@@ -233,7 +331,7 @@ Value cmd_getkeychains(Server& /*server*/, websocketpp::connection_hdl /*hdl*/,
         obj.push_back(Pair("private", view.is_private));
         obj.push_back(Pair("encrypted", view.is_encrypted));
         obj.push_back(Pair("locked", view.is_locked));
-        obj.push_back(Pair("hash", uchar_vector(view.hash).getHex()));
+        obj.push_back(Pair("hash", toHex(view.hash)));
         keychainObjects.push_back(obj);
     }
 
@@ -290,7 +388,10 @@ Value cmd_newaccount(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Sy
     Vault* vault = synchedVault.getVault();
 
     vault->newAccount(accountName, minsigs, keychainNames);
+    reportJobProgress(1, 2);
+    releaseVaultLock();
     synchedVault.syncBlocks();
+    reportJobProgress(2, 2);
     AccountInfo accountInfo = vault->getAccountInfo(accountName);
     return getAccountInfoObject(accountInfo);
 }
@@ -369,7 +470,7 @@ Value cmd_issuescript(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, S
     std::shared_ptr<SigningScript> script = vault->issueSigningScript(accountName, binName, label, index);
     if (synchedVault.isConnected()) { synchedVault.updateBloomFilter(); }
 
-    std::string address = CoinQ::Script::getAddressForTxOutScript(script->txoutscript(), getCoinParams().address_versions());
+    std::string address = getAddressCache().getAddress(script->txoutscript());
     std::string uri = "bitcoin:";
     uri += address;
     if (!label.empty()) { uri += "?label="; uri += label; }
@@ -379,7 +480,7 @@ Value cmd_issuescript(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, S
     result.push_back(Pair("label", label));
     result.push_back(Pair("accountbin", binName));
     result.push_back(Pair("index", (uint64_t)script->index()));
-    result.push_back(Pair("script", uchar_vector(script->txoutscript()).getHex()));
+    result.push_back(Pair("script", toHex(script->txoutscript())));
     result.push_back(Pair("address", address));
     result.push_back(Pair("uri", uri)); 
     return result;
@@ -404,7 +505,7 @@ Value cmd_issuecontactscript(Server& /*server*/, websocketpp::connection_hdl /*h
     std::shared_ptr<SigningScript> script = vault->issueSigningScript(accountName, binName, label, 0, userName);
     if (synchedVault.isConnected()) { synchedVault.updateBloomFilter(); }
 
-    std::string address = CoinQ::Script::getAddressForTxOutScript(script->txoutscript(), getCoinParams().address_versions());
+    std::string address = getAddressCache().getAddress(script->txoutscript());
     std::string uri = "bitcoin:";
     uri += address;
     if (!label.empty()) { uri += "?label="; uri += label; }
@@ -415,7 +516,7 @@ Value cmd_issuecontactscript(Server& /*server*/, websocketpp::connection_hdl /*h
     result.push_back(Pair("label", label));
     result.push_back(Pair("accountbin", binName));
     result.push_back(Pair("index", (uint64_t)script->index()));
-    result.push_back(Pair("script", uchar_vector(script->txoutscript()).getHex()));
+    result.push_back(Pair("script", toHex(script->txoutscript())));
     result.push_back(Pair("address", address));
     result.push_back(Pair("uri", uri)); 
     return result;
@@ -435,11 +536,15 @@ Value cmd_importaccountfromfile(Server& /*server*/, websocketpp::connection_hdl
     {
         unsigned int privkeysimported = 1;        
         vault->importAccount(filepath, privkeysimported);
+        reportJobProgress(1, 2);
+        releaseVaultLock();
         synchedVault.syncBlocks();
+        reportJobProgress(2, 2);
         return Value("success");
     }
     catch (const exception& e)
     {
+        releaseVaultLock();
         synchedVault.syncBlocks();
         throw e;
     }
@@ -474,13 +579,17 @@ Value cmd_synctxs(Server& server, websocketpp::connection_hdl hdl, SynchedVault&
     std::vector<Object> txViewObjs; 
     for (auto& txview: txviews)
     {
+        checkDeadline();
         shared_ptr<Tx> tx = vault->getTx(txview.hash);
         txs.push_back(tx);
     }
 
+    uint64_t sent = 0;
     for (auto& tx: txs)
     {
+        checkDeadline();
         sendTxJsonEvent(UPDATED, server, hdl, synchedVault, tx);
+        reportJobProgress(++sent, txs.size());
     }
 
     Object result;
@@ -500,6 +609,7 @@ Value cmd_gethistory(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Sy
     std::vector<Object> txViewObjs; 
     for (auto& txview: txviews)
     {
+        checkDeadline();
         txViewObjs.push_back(getTxViewObject(txview));
     }
 
@@ -520,6 +630,7 @@ Value cmd_getunsigned(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, S
     std::vector<Object> txViewObjs; 
     for (auto& txview: txviews)
     {
+        checkDeadline();
         txViewObjs.push_back(getTxViewObject(txview));
     }
 
@@ -538,7 +649,7 @@ Value cmd_gettx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Synched
     std::shared_ptr<Tx> tx;
     if (params[0].type() == str_type)
     {
-        uchar_vector hash(params[0].get_str());
+        bytes_t hash = getHexParam(params[0]);
         tx = vault->getTx(hash); 
     }
     else if (params[0].type() == int_type)
@@ -577,7 +688,7 @@ Value cmd_getserializedtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*
     std::shared_ptr<Tx> tx;
     if (params[0].type() == str_type)
     {
-        uchar_vector hash(params[0].get_str());
+        bytes_t hash = getHexParam(params[0]);
         tx = vault->getTx(hash); 
     }
     else if (params[0].type() == int_type)
@@ -592,7 +703,7 @@ Value cmd_getserializedtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*
     string serializedTx = vault->exportTx(tx);
 
     Object result;
-    result.push_back(Pair("hash", uchar_vector(tx->hash()).getHex()));
+    result.push_back(Pair("hash", toHex(tx->hash())));
     result.push_back(Pair("serializedtx", serializedTx));
     return result;
 }
@@ -712,7 +823,7 @@ Value cmd_createtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Sync
                 for (auto& txout: txouts)
                 {
                     body << "    label:   " << txout->sending_label() << "\r\n"
-                         << "    address: " << CoinQ::Script::getAddressForTxOutScript(txout->script(), getCoinParams().address_versions()) << "\r\n"
+                         << "    address: " << getAddressCache().getAddress(txout->script()) << "\r\n"
                          << "    amount:  " << txout->value() << "\r\n\r\n";
                 }
                 getSmtpTls().setBody(body.str());
@@ -796,7 +907,7 @@ Value cmd_gettxproposal(Server& server, websocketpp::connection_hdl hdl, Synched
     if (params.size() != 1 || params[0].type() != str_type)
         throw CommandInvalidParametersException();
 
-    uchar_vector hash(params[0].get_str());
+    bytes_t hash = getHexParam(params[0]);
     shared_ptr<TxProposal> txProposal = getTxProposal(hash);
 
     return getTxProposalObject(*txProposal);
@@ -807,7 +918,7 @@ Value cmd_canceltxproposal(Server& server, websocketpp::connection_hdl hdl, Sync
     if (params.size() != 1 || params[0].type() != str_type)
         throw CommandInvalidParametersException();
 
-    uchar_vector hash(params[0].get_str());
+    bytes_t hash = getHexParam(params[0]);
     cancelTxProposal(hash);
 
     return Value("success");
@@ -820,7 +931,7 @@ Value cmd_submittxproposal(Server& server, websocketpp::connection_hdl hdl, Sync
 
     shared_ptr<TxProposal> txProposal;
     shared_ptr<Tx> tx;
-    uchar_vector hash(params[0].get_str());
+    bytes_t hash = getHexParam(params[0]);
     submitTxProposal(hash);
 
     return Value("success");
@@ -853,7 +964,7 @@ Value cmd_approvetx(Server& server, websocketpp::connection_hdl hdl, SynchedVaul
 
     shared_ptr<TxProposal> txSubmission;
     shared_ptr<Tx> tx;
-    uchar_vector hash(params[0].get_str());
+    bytes_t hash = getHexParam(params[0]);
 
     {
         lock_guard<mutex> lock(g_txSubmissionMutex);
@@ -872,7 +983,7 @@ Value cmd_canceltx(Server& server, websocketpp::connection_hdl hdl, SynchedVault
 
     shared_ptr<TxProposal> txSubmission;
     shared_ptr<Tx> tx;
-    uchar_vector hash(params[0].get_str());
+    bytes_t hash = getHexParam(params[0]);
 
     {
         lock_guard<mutex> lock(g_txSubmissionMutex);
@@ -891,7 +1002,7 @@ Value cmd_rejecttx(Server& server, websocketpp::connection_hdl hdl, SynchedVault
 
     shared_ptr<TxProposal> txSubmission;
     shared_ptr<Tx> tx;
-    uchar_vector hash(params[0].get_str());
+    bytes_t hash = getHexParam(params[0]);
 
     {
         lock_guard<mutex> lock(g_txSubmissionMutex);
@@ -978,7 +1089,7 @@ Value cmd_newlabeledtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/,
                 for (auto& txout: txouts)
                 {
                     body << "    label:   " << txout->sending_label() << "\r\n"
-                         << "    address: " << CoinQ::Script::getAddressForTxOutScript(txout->script(), getCoinParams().address_versions()) << "\r\n"
+                         << "    address: " << getAddressCache().getAddress(txout->script()) << "\r\n"
                          << "    amount:  " << txout->value() << "\r\n\r\n";
                 }
                 getSmtpTls().setBody(body.str());
@@ -1013,7 +1124,7 @@ Value cmd_getsigningrequest(Server& /*server*/, websocketpp::connection_hdl /*hd
     SigningRequest req;
     if (params[0].type() == str_type)
     {
-        req = vault->getSigningRequest(uchar_vector(params[0].get_str()), true);
+        req = vault->getSigningRequest(getHexParam(params[0]), true);
     }
     else if (params[0].type() == int_type)
     {
@@ -1045,7 +1156,7 @@ Value cmd_signtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Synche
         if (params[0].type() == str_type)
         {
             vault->unlockKeychain(keychain, secure_bytes_t());
-            tx = vault->signTx(uchar_vector(params[0].get_str()), keychains, true);
+            tx = vault->signTx(getHexParam(params[0]), keychains, true);
         }
         else if (params[0].type() == int_type)
         {
@@ -1083,7 +1194,7 @@ Value cmd_insertrawtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, S
 
     Vault* vault = synchedVault.getVault();
 
-    uchar_vector rawtx(params[0].get_str());
+    bytes_t rawtx = getHexParam(params[0]);
     std::shared_ptr<Tx> tx(new Tx());
     tx->set(rawtx, time(NULL), Tx::UNSENT);
     tx = vault->insertTx(tx);
@@ -1149,7 +1260,7 @@ Value cmd_sendtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Synche
     std::shared_ptr<Tx> tx;
     if (params[0].type() == str_type)
     {
-        uchar_vector hash(params[0].get_str());
+        bytes_t hash = getHexParam(params[0]);
         tx = synchedVault.sendTx(hash); 
     }
     else if (params[0].type() == int_type)
@@ -1162,8 +1273,8 @@ Value cmd_sendtx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Synche
     }
 
     Object result;
-    result.push_back(Pair("hash", uchar_vector(tx->hash()).getHex()));
-    result.push_back(Pair("rawtx", uchar_vector(tx->raw()).getHex()));
+    result.push_back(Pair("hash", toHex(tx->hash())));
+    result.push_back(Pair("rawtx", toHex(tx->raw())));
     return result;
 }
 
@@ -1177,7 +1288,7 @@ Value cmd_deletetx(Server& /*server*/, websocketpp::connection_hdl /*hdl*/, Sync
     std::shared_ptr<Tx> tx;
     if (params[0].type() == str_type)
     {
-        uchar_vector hash(params[0].get_str());
+        bytes_t hash = getHexParam(params[0]);
         tx = vault->getTx(hash);
         if (tx->status() >= Tx::PROPAGATED) throw OperationTransactionNotDeletedException();
 
@@ -1209,7 +1320,7 @@ Value cmd_getblockheader(Server& /*server*/, websocketpp::connection_hdl /*hdl*/
     std::shared_ptr<BlockHeader> header;
     if (params[0].type() == str_type)
     {
-        uchar_vector hash(params[0].get_str());
+        bytes_t hash = getHexParam(params[0]);
         header = vault->getBlockHeader(hash);
     }
     else if (params[0].type() == int_type)
@@ -1358,7 +1469,7 @@ Value cmd_faketx(WebSocket::Server& server, websocketpp::connection_hdl hdl, Coi
     std::shared_ptr<Tx> tx = std::make_shared<Tx>();
     tx->set(1, txins, txouts, 0, time(NULL), Tx::UNSIGNED);
 
-    sendTxChannelEvent(INSERTED, server, synchedVault, tx, true);
+    getEventDispatcher().postTx(INSERTED, tx, true);
     return Value("success");
 }
 
@@ -1367,82 +1478,109 @@ Value cmd_forcestatus(WebSocket::Server& server, websocketpp::connection_hdl hdl
     if (params.size() != 0)
         throw CommandInvalidParametersException();
 
-    sendStatusEvent(server, synchedVault);
+    getEventDispatcher().postStatus();
     return Value("success");
 }
 
-void initCommandMap(command_map_t& command_map)
+// Method name, handler and access mode of every command exposed to clients.
+// Each entry X(name, access) dispatches to cmd_<name>.
+#define COMMAND_TABLE(X) \
+    /* Channel operations */ \
+    X(subscribe,                  NO_VAULT) \
+    X(unsubscribe,                NO_VAULT) \
+    X(getchannels,                NO_VAULT) \
+    \
+    /* Global operations */ \
+    X(getstatus,                  READ_ONLY) \
+    /* X(setvaultfromfile,           MUTATING) */ \
+    /* X(exportvaulttofile,          READ_ONLY) */ \
+    X(getmetrics,                 NO_VAULT) \
+    X(settimeout,                 NO_VAULT) \
+    X(setcompression,             NO_VAULT) \
+    X(setencoding,                NO_VAULT) \
+    \
+    /* Keychain operations */ \
+    X(newkeychain,                MUTATING) \
+    X(renamekeychain,             MUTATING) \
+    X(getkeychaininfo,            READ_ONLY) \
+    X(getkeychains,               READ_ONLY) \
+    X(exportbip32,                READ_ONLY) \
+    X(importbip32,                MUTATING) \
+    \
+    /* Account operations */ \
+    X(newaccount,                 MUTATING) \
+    X(renameaccount,              MUTATING) \
+    X(getaccountinfo,             READ_ONLY) \
+    X(getaccounts,                READ_ONLY) \
+    X(issuescript,                MUTATING) \
+    X(issuecontactscript,         MUTATING) \
+    X(importaccountfromfile,      MUTATING) \
+    /* X(exportaccounttofile,        READ_ONLY) */ \
+    \
+    /* Tx operations */ \
+    X(synctxs,                    READ_ONLY) \
+    X(gethistory,                 READ_ONLY) \
+    X(getunsigned,                READ_ONLY) \
+    X(gettx,                      READ_ONLY) \
+    X(getserializedtx,            READ_ONLY) \
+    X(getserializedunsignedtxs,   READ_ONLY) \
+    X(proposetx,                  MUTATING) \
+    X(gettxproposal,              READ_ONLY) \
+    X(listtxproposals,            READ_ONLY) \
+    X(canceltxproposal,           MUTATING) \
+    X(submittxproposal,           MUTATING) \
+    X(listtxsubmissions,          READ_ONLY) \
+    X(approvetx,                  MUTATING) \
+    X(canceltx,                   MUTATING) \
+    X(rejecttx,                   MUTATING) \
+    X(listprocessedtxsubmissions, READ_ONLY) \
+    X(newtx,                      MUTATING) \
+    X(createtx,                   MUTATING) \
+    X(newlabeledtx,               MUTATING) \
+    X(getsigningrequest,          READ_ONLY) \
+    X(signtx,                     MUTATING) \
+    X(insertrawtx,                MUTATING) \
+    X(insertserializedtx,         MUTATING) \
+    X(sendtx,                     MUTATING) \
+    X(deletetx,                   MUTATING) \
+    \
+    /* Blockchain operations */ \
+    X(getblockheader,             READ_ONLY) \
+    X(getchaintip,                READ_ONLY) \
+    \
+    /* User operations */ \
+    X(adduser,                    MUTATING) \
+    X(getuser,                    READ_ONLY) \
+    X(addaddresstowhitelist,      MUTATING) \
+    X(removeaddressfromwhitelist, MUTATING) \
+    X(clearaddresswhitelist,      MUTATING) \
+    \
+    /* Test operations */ \
+    /* X(fakemerkleblock,            MUTATING) */ \
+    X(faketx,                     MUTATING) \
+    X(forcestatus,                MUTATING)
+
+#define COMMAND_ID(name, access)    COMMAND_ID_##name,
+#define COMMAND_ENTRY(name, access) Command(#name, &cmd_##name, Command::access),
+#define COMMAND_CASE(name, access)  case hashCommandName(#name): return method == #name ? &g_commands[COMMAND_ID_##name] : nullptr;
+
+enum CommandId { COMMAND_TABLE(COMMAND_ID) COMMAND_COUNT };
+
+static const Command g_commands[] = { COMMAND_TABLE(COMMAND_ENTRY) };
+
+const Command* getCommand(const std::string& method)
 {
-    command_map.clear();
-
-    // Channel operations
-    command_map.insert(cmd_pair("subscribe", Command(&cmd_subscribe)));
-    command_map.insert(cmd_pair("unsubscribe", Command(&cmd_unsubscribe)));
-    command_map.insert(cmd_pair("getchannels", Command(&cmd_getchannels)));
-
-    // Global operations
-    command_map.insert(cmd_pair("getstatus", Command(&cmd_getstatus)));
-    //command_map.insert(cmd_pair("setvaultfromfile", Command(&cmd_setvaultfromfile)));
-    //command_map.insert(cmd_pair("exportvaulttofile", Command(&cmd_exportvaulttofile)));
-
-    // Keychain operations
-    command_map.insert(cmd_pair("newkeychain", Command(&cmd_newkeychain)));
-    command_map.insert(cmd_pair("renamekeychain", Command(&cmd_renamekeychain)));
-    command_map.insert(cmd_pair("getkeychaininfo", Command(&cmd_getkeychaininfo)));
-    command_map.insert(cmd_pair("getkeychains", Command(&cmd_getkeychains)));
-    command_map.insert(cmd_pair("exportbip32", Command(&cmd_exportbip32)));
-    command_map.insert(cmd_pair("importbip32", Command(&cmd_importbip32)));
-
-    // Account operations
-    command_map.insert(cmd_pair("newaccount", Command(&cmd_newaccount)));
-    command_map.insert(cmd_pair("renameaccount", Command(&cmd_renameaccount)));
-    command_map.insert(cmd_pair("getaccountinfo", Command(&cmd_getaccountinfo)));
-    command_map.insert(cmd_pair("getaccounts", Command(&cmd_getaccounts)));
-    command_map.insert(cmd_pair("issuescript", Command(&cmd_issuescript)));
-    command_map.insert(cmd_pair("issuecontactscript", Command(&cmd_issuecontactscript)));
-    command_map.insert(cmd_pair("importaccountfromfile", Command(&cmd_importaccountfromfile)));
-    //command_map.insert(cmd_pair("exportaccounttofile", Command(&cmd_exportaccounttofile)));
-
-    // Tx operations
-    command_map.insert(cmd_pair("synctxs", Command(&cmd_synctxs)));
-    command_map.insert(cmd_pair("gethistory", Command(&cmd_gethistory)));
-    command_map.insert(cmd_pair("getunsigned", Command(&cmd_getunsigned)));
-    command_map.insert(cmd_pair("gettx", Command(&cmd_gettx)));
-    command_map.insert(cmd_pair("getserializedtx", Command(&cmd_getserializedtx)));
-    command_map.insert(cmd_pair("getserializedunsignedtxs", Command(&cmd_getserializedunsignedtxs)));
-    command_map.insert(cmd_pair("proposetx", Command(&cmd_proposetx)));
-    command_map.insert(cmd_pair("gettxproposal", Command(&cmd_gettxproposal)));
-    command_map.insert(cmd_pair("listtxproposals", Command(&cmd_listtxproposals)));
-    command_map.insert(cmd_pair("canceltxproposal", Command(&cmd_canceltxproposal)));
-    command_map.insert(cmd_pair("submittxproposal", Command(&cmd_submittxproposal)));
-    command_map.insert(cmd_pair("listtxsubmissions", Command(&cmd_listtxsubmissions)));
-    command_map.insert(cmd_pair("approvetx", Command(&cmd_approvetx)));
-    command_map.insert(cmd_pair("canceltx", Command(&cmd_canceltx)));
-    command_map.insert(cmd_pair("rejecttx", Command(&cmd_rejecttx)));
-    command_map.insert(cmd_pair("listprocessedtxsubmissions", Command(&cmd_listprocessedtxsubmissions)));
-    command_map.insert(cmd_pair("newtx", Command(&cmd_newtx)));
-    command_map.insert(cmd_pair("createtx", Command(&cmd_createtx)));
-    command_map.insert(cmd_pair("newlabeledtx", Command(&cmd_newlabeledtx)));
-    command_map.insert(cmd_pair("getsigningrequest", Command(&cmd_getsigningrequest)));
-    command_map.insert(cmd_pair("signtx", Command(&cmd_signtx)));
-    command_map.insert(cmd_pair("insertrawtx", Command(&cmd_insertrawtx)));
-    command_map.insert(cmd_pair("insertserializedtx", Command(&cmd_insertserializedtx)));
-    command_map.insert(cmd_pair("sendtx", Command(&cmd_sendtx)));
-    command_map.insert(cmd_pair("deletetx", Command(&cmd_deletetx)));
-
-    // Blockchain operations
-    command_map.insert(cmd_pair("getblockheader", Command(&cmd_getblockheader)));
-    command_map.insert(cmd_pair("getchaintip", Command(&cmd_getchaintip)));
-
-    // User operations
-    command_map.insert(cmd_pair("adduser", Command(&cmd_adduser)));
-    command_map.insert(cmd_pair("getuser", Command(&cmd_getuser)));
-    command_map.insert(cmd_pair("addaddresstowhitelist", Command(&cmd_addaddresstowhitelist)));
-    command_map.insert(cmd_pair("removeaddressfromwhitelist", Command(&cmd_removeaddressfromwhitelist)));
-    command_map.insert(cmd_pair("clearaddresswhitelist", Command(&cmd_clearaddresswhitelist)));
-
-    // Test operations
-    //command_map.insert(cmd_pair("fakemerkleblock", Command(&cmd_fakemerkleblock)));
-    command_map.insert(cmd_pair("faketx", Command(&cmd_faketx)));
-    command_map.insert(cmd_pair("forcestatus", Command(&cmd_forcestatus)));
+    switch (hashCommandName(method))
+    {
+    COMMAND_TABLE(COMMAND_CASE)
+    default:
+        return nullptr;
+    }
 }
+
+const Command* getCommands() { return g_commands; }
+size_t getCommandCount() { return COMMAND_COUNT; }
+
+#undef COMMAND_CASE
+#undef COMMAND_ENTRY
+#undef COMMAND_ID
@@ -17,20 +17,29 @@
 #include <SimpleSmtp/smtp.h>
 
 #include <string>
-#include <map>
-#include <functional>
+#include <cstdint>
+#include <cstddef>
 
 #include <json_spirit/json_spirit_value.h>
 #include <WebSocketAPI/Server.h>
 
 namespace CoinDB { class SynchedVault; }
 
-typedef std::function<json_spirit::Value(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault&, const json_spirit::Array&)> cmd_t;
+typedef json_spirit::Value (*cmd_t)(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault&, const json_spirit::Array&);
 
 class Command
 {
 public:
-    Command(cmd_t cmd) : m_cmd(cmd) { }
+    // Commands that never touch the vault run without the vault lock.
+    // Read-only commands may run concurrently with each other. Mutating
+    // commands are serialized against every other vault command.
+    enum access_t { NO_VAULT, READ_ONLY, MUTATING };
+
+    constexpr Command(const char* name, cmd_t cmd, access_t access) : m_name(name), m_cmd(cmd), m_access(access) { }
+
+    const char* name() const { return m_name; }
+    access_t access() const { return m_access; }
+    bool isReadOnly() const { return m_access != MUTATING; }
 
     json_spirit::Value operator()(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params) const
     {
@@ -38,11 +47,32 @@ public:
     }
 
 private:
+    const char* m_name;
     cmd_t m_cmd;
+    access_t m_access;
 };
 
-typedef std::pair<std::string, Command> cmd_pair;
-typedef std::map<std::string, Command>  command_map_t;
+// FNV-1a over the method name. The constexpr form is evaluated at compile
+// time for the dispatch table's case labels, so any collision between two
+// method names is a compile error and the table is a perfect hash.
+constexpr uint32_t hashCommandName(const char* name, uint32_t hash = 2166136261u)
+{
+    return *name ? hashCommandName(name + 1, (hash ^ (uint32_t)(unsigned char)*name) * 16777619u) : hash;
+}
+
+inline uint32_t hashCommandName(const std::string& name)
+{
+    uint32_t hash = 2166136261u;
+    for (auto c: name) { hash = (hash ^ (uint32_t)(unsigned char)c) * 16777619u; }
+    return hash;
+}
+
+// Returns nullptr if the method does not exist.
+const Command* getCommand(const std::string& method);
+
+// The full command table, indexed by command id.
+const Command* getCommands();
+size_t getCommandCount();
 
 void setDocumentDir(const std::string& documentDir);
 const std::string& getDocumentDir();
@@ -56,6 +86,10 @@ json_spirit::Value cmd_getchannels(WebSocket::Server& server, websocketpp::conne
 json_spirit::Value cmd_getstatus(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
 json_spirit::Value cmd_setvaultfromfile(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
 json_spirit::Value cmd_exportvaulttofile(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
+json_spirit::Value cmd_getmetrics(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
+json_spirit::Value cmd_settimeout(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
+json_spirit::Value cmd_setencoding(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
+json_spirit::Value cmd_setcompression(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
 
 // Keychain operations
 json_spirit::Value cmd_newkeychain(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
@@ -142,5 +176,3 @@ json_spirit::Value cmd_sendmany(WebSocket::Server& server, websocketpp::connecti
 json_spirit::Value cmd_sendrawtransaction(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
 json_spirit::Value cmd_sendtoaddress(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
 json_spirit::Value cmd_validateaddress(WebSocket::Server& server, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, const json_spirit::Array& params);
-
-void initCommandMap(command_map_t& command_map);
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// compression.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "compression.h"
+
+#include <logger/logger.h>
+
+using namespace CoinSocket;
+using namespace json_spirit;
+using namespace std;
+
+// Deflate memory per connection is about 2^(MAX_WBITS + 2) + 2^(memLevel + 9).
+const int COMPRESSION_MEM_LEVEL = 8;
+
+Compressor::Stream::Stream()
+{
+    m_stream.zalloc = Z_NULL;
+    m_stream.zfree = Z_NULL;
+    m_stream.opaque = Z_NULL;
+
+    // Negative window bits for a raw stream, as in permessage-deflate.
+    m_bReady = deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, COMPRESSION_MEM_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK;
+    if (!m_bReady) { LOGGER(error) << "Compressor - deflateInit2 failed." << endl; }
+}
+
+Compressor::Stream::~Stream()
+{
+    if (m_bReady) { deflateEnd(&m_stream); }
+}
+
+bool Compressor::Stream::deflate(const string& in, string& out)
+{
+    if (!m_bReady) return false;
+
+    m_stream.next_in = (Bytef*)in.data();
+    m_stream.avail_in = in.size();
+
+    // Room for the sync flush marker on top of the usual bound. Output that
+    // still does not fit is collected in further chunks.
+    size_t chunk = deflateBound(&m_stream, in.size()) + 6;
+    out.clear();
+    do
+    {
+        size_t used = out.size();
+        out.resize(used + chunk);
+        m_stream.next_out = (Bytef*)&out[used];
+        m_stream.avail_out = chunk;
+
+        int ret = ::deflate(&m_stream, Z_SYNC_FLUSH);
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            // The client's stream can no longer follow this one.
+            deflateEnd(&m_stream);
+            m_bReady = false;
+            return false;
+        }
+        out.resize(used + chunk - m_stream.avail_out);
+    } while (m_stream.avail_out == 0);
+
+    if (out.size() >= 4 && out.compare(out.size() - 4, 4, string("\x00\x00\xff\xff", 4)) == 0) { out.resize(out.size() - 4); }
+    return true;
+}
+
+void Compressor::setThreshold(size_t threshold)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_threshold = threshold;
+}
+
+void Compressor::setEnabled(websocketpp::connection_hdl hdl, bool bEnabled)
+{
+    if (hdl.expired()) return;
+
+    lock_guard<mutex> lock(m_mutex);
+    if (!bEnabled)                  { m_streams.erase(hdl); }
+    else if (!m_streams.count(hdl)) { m_streams[hdl] = make_shared<Stream>(); }
+}
+
+void Compressor::removeConnection(websocketpp::connection_hdl hdl)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_streams.erase(hdl);
+}
+
+payload_ptr Compressor::encode(websocketpp::connection_hdl hdl, const payload_ptr& payload, bool& bBinary)
+{
+    stream_ptr stream;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        auto it = m_streams.find(hdl);
+        if (it == m_streams.end()) return payload;
+        if (!bBinary && payload->size() < m_threshold) return payload;
+        stream = it->second;
+    }
+
+    // Binary frames are always deflated on a compressed connection, so the
+    // client never has to guess which ones are.
+    string deflated;
+    if (!stream->deflate(*payload, deflated))
+    {
+        LOGGER(error) << "Compressor - deflate failed for connection " << hdl.lock().get() << "." << endl;
+        return payload_ptr();
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    m_compressedMessages++;
+    m_uncompressedBytes += payload->size();
+    m_compressedBytes += deflated.size();
+    bBinary = true;
+    return make_shared<const string>(move(deflated));
+}
+
+Object Compressor::getMetricsObject()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Object result;
+    result.push_back(Pair("connections", (uint64_t)m_streams.size()));
+    result.push_back(Pair("compressed", m_compressedMessages));
+    result.push_back(Pair("uncompressedbytes", m_uncompressedBytes));
+    result.push_back(Pair("compressedbytes", m_compressedBytes));
+    return result;
+}
+
+Compressor& CoinSocket::getCompressor()
+{
+    static Compressor compressor;
+    return compressor;
+}
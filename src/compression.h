@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// compression.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include "outbound.h"
+
+#include <json_spirit/json_spirit_value.h>
+#include <WebSocketAPI/Server.h>
+
+#include <zlib.h>
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Deflate compression for connections that ask for it. Each connection has
+// its own raw deflate stream with context takeover, as in permessage-deflate
+// (RFC 7692), and every deflated message is sent as a binary frame ending in
+// a sync flush with the trailing 00 00 ff ff removed. A client enabling
+// compression starts a new inflate stream and feeds it every binary frame
+// after that. Text frames are never deflated. Messages are deflated as they
+// are sent, after any dropping or coalescing in the outbound queue, so the
+// client's stream never misses a message.
+class Compressor
+{
+public:
+    Compressor() : m_threshold(0), m_compressedMessages(0), m_uncompressedBytes(0), m_compressedBytes(0) { }
+
+    // Text messages smaller than this are sent as they are.
+    void setThreshold(size_t threshold);
+
+    // Enabling compression again keeps the connection's stream.
+    void setEnabled(websocketpp::connection_hdl hdl, bool bEnabled);
+    void removeConnection(websocketpp::connection_hdl hdl);
+
+    // Only called from the outbound sender thread. bBinary says whether the
+    // payload is a binary frame and is set if what is returned is one.
+    // Returns null if the connection's stream has failed, after which the
+    // connection has to be closed.
+    payload_ptr encode(websocketpp::connection_hdl hdl, const payload_ptr& payload, bool& bBinary);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    class Stream
+    {
+    public:
+        Stream();
+        ~Stream();
+
+        bool deflate(const std::string& in, std::string& out);
+
+    private:
+        z_stream m_stream;
+        bool m_bReady;
+    };
+
+    typedef std::shared_ptr<Stream> stream_ptr;
+    typedef std::map<websocketpp::connection_hdl, stream_ptr, std::owner_less<websocketpp::connection_hdl>> stream_map_t;
+
+    std::mutex m_mutex;
+    stream_map_t m_streams;
+    size_t m_threshold;
+
+    uint64_t m_compressedMessages;
+    uint64_t m_uncompressedBytes;
+    uint64_t m_compressedBytes;
+};
+
+Compressor& getCompressor();
+
+}
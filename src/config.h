@@ -13,6 +13,9 @@
 #pragma once
 
 #include "CoinSocketExceptions.h"
+#include "outbound.h"
+#include "ratelimit.h"
+#include "coalescer.h"
 #include <CoinQ/CoinQ_coinparams.h>
 
 #include <string>
@@ -32,6 +35,43 @@ const std::string DEFAULT_PEER_HOST = "localhost";
 const std::string DEFAULT_WEBSOCKET_PORT = "8080";
 const std::string DEFAULT_ALLOWED_IPS = "^\\[(::1|::ffff:127\\.0\\.0\\.1)\\].*";
 const uint32_t    DEFAULT_MIN_CONF = 3;
+const uint32_t    DEFAULT_COMMAND_THREADS = 4;
+const uint32_t    DEFAULT_JOB_THREADS = 2;
+const uint32_t    DEFAULT_OUTQUEUE_MESSAGES = 10000;
+const uint32_t    DEFAULT_OUTQUEUE_BYTES = 64 * 1024 * 1024;
+const std::string DEFAULT_OUTQUEUE_POLICY = "dropoldest";
+const uint32_t    DEFAULT_MAX_PENDING_COMMANDS = 1000;
+const uint32_t    DEFAULT_REQUEST_TIMEOUT = 0;
+const uint32_t    DEFAULT_IDEMPOTENCY_KEYS = 1000;
+const uint32_t    DEFAULT_REPLAY_EVENTS = 10000;
+const uint32_t    DEFAULT_REPLAY_RETAIN = 60;
+const uint32_t    DEFAULT_COMPRESS_THRESHOLD = 1024;
+const uint32_t    DEFAULT_FINALITY_TXS = 100000;
+const uint32_t    DEFAULT_MERKLE_BLOCK_BATCH = 0;
+const uint32_t    DEFAULT_MERKLE_BLOCK_BATCH_WINDOW = 1000;
+const uint32_t    DEFAULT_ADDRESS_CACHE = 100000;
+const uint32_t    DEFAULT_TX_JSON_CACHE = 10000;
+const std::string DEFAULT_LOG_LEVEL = "debug";
+
+// Least severe level of the per-request and per-event messages that are
+// logged. Checked before such a message is built, so its text is never
+// formatted only to be thrown away.
+enum LogLevel
+{
+    LOG_TRACE,
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_ERROR
+};
+
+inline bool getLogLevel(const std::string& name, LogLevel& level)
+{
+    if (name == "trace")    { level = LOG_TRACE;    return true; }
+    if (name == "debug")    { level = LOG_DEBUG;    return true; }
+    if (name == "info")     { level = LOG_INFO;     return true; }
+    if (name == "error")    { level = LOG_ERROR;    return true; }
+    return false;
+}
 
 class CoinSocketConfig;
 
@@ -70,6 +110,26 @@ public:
     const std::string&              getSmtpFrom() const { return m_smtpFrom; }
     const CoinQ::CoinParams&        getCoinParams() const { return m_networkSelector.getCoinParams(); }
     uint32_t                        getMinConf() const { return m_minConf; }
+    uint32_t                        getCommandThreads() const { return m_commandThreads; }
+    uint32_t                        getJobThreads() const { return m_jobThreads; }
+    uint32_t                        getOutQueueMessages() const { return m_outQueueMessages; }
+    uint32_t                        getOutQueueBytes() const { return m_outQueueBytes; }
+    const std::string&              getOutQueuePolicy() const { return m_outQueuePolicy; }
+    CoinSocket::RateLimit           getRateLimit() const { return CoinSocket::RateLimit(m_rateLimit, m_rateBurst); }
+    const CoinSocket::MethodRateLimits& getMethodRateLimits() const { return m_methodRateLimits; }
+    uint32_t                        getMaxPendingCommands() const { return m_maxPendingCommands; }
+    uint32_t                        getRequestTimeout() const { return m_requestTimeout; }
+    uint32_t                        getIdempotencyKeys() const { return m_idempotencyKeys; }
+    const CoinSocket::CoalesceWindows& getCoalesceWindows() const { return m_coalesceWindows; }
+    uint32_t                        getReplayEvents() const { return m_replayEvents; }
+    uint32_t                        getReplayRetain() const { return m_replayRetain; }
+    uint32_t                        getCompressThreshold() const { return m_compressThreshold; }
+    uint32_t                        getFinalityTxs() const { return m_finalityTxs; }
+    uint32_t                        getMerkleBlockBatch() const { return m_merkleBlockBatch; }
+    uint32_t                        getMerkleBlockBatchWindow() const { return m_merkleBlockBatchWindow; }
+    uint32_t                        getAddressCache() const { return m_addressCache; }
+    uint32_t                        getTxJsonCache() const { return m_txJsonCache; }
+    bool                            isLogged(LogLevel level) const { return level >= m_logLevel; }
 
     bool                        help() const { return m_bHelp; }
     const std::string&          getHelpOptions() const { return m_helpOptions; }
@@ -101,6 +161,30 @@ private:
     std::string m_smtpUrl;
     std::string m_smtpFrom;
     uint32_t    m_minConf;
+    uint32_t    m_commandThreads;
+    uint32_t    m_jobThreads;
+    uint32_t    m_outQueueMessages;
+    uint32_t    m_outQueueBytes;
+    std::string m_outQueuePolicy;
+    double      m_rateLimit;
+    double      m_rateBurst;
+    std::vector<std::string> m_methodRateLimitStrs;
+    CoinSocket::MethodRateLimits m_methodRateLimits;
+    uint32_t    m_maxPendingCommands;
+    uint32_t    m_requestTimeout;
+    uint32_t    m_idempotencyKeys;
+    std::vector<std::string> m_coalesceWindowStrs;
+    CoinSocket::CoalesceWindows m_coalesceWindows;
+    uint32_t    m_replayEvents;
+    uint32_t    m_replayRetain;
+    uint32_t    m_compressThreshold;
+    uint32_t    m_finalityTxs;
+    uint32_t    m_merkleBlockBatch;
+    uint32_t    m_merkleBlockBatchWindow;
+    uint32_t    m_addressCache;
+    uint32_t    m_txJsonCache;
+    std::string m_logLevelStr;
+    LogLevel    m_logLevel;
 
     bool        m_bHelp;
     std::string m_helpOptions;
@@ -135,6 +219,27 @@ inline void CoinSocketConfig::init(int argc, char* argv[])
         ("smtpurl", po::value<std::string>(&m_smtpUrl), "smtp url for sending email alerts")
         ("smtpfrom", po::value<std::string>(&m_smtpFrom), "smtp from for sending email alerts")
         ("minconf", po::value<uint32_t>(&m_minConf), "minimum number of confirmations to make transaction final")
+        ("commandthreads", po::value<uint32_t>(&m_commandThreads), "number of threads executing client commands")
+        ("jobthreads", po::value<uint32_t>(&m_jobThreads), "number of threads executing commands submitted as jobs")
+        ("outqueuemessages", po::value<uint32_t>(&m_outQueueMessages), "maximum number of messages queued for a client")
+        ("outqueuebytes", po::value<uint32_t>(&m_outQueueBytes), "maximum number of bytes queued for a client")
+        ("outqueuepolicy", po::value<std::string>(&m_outQueuePolicy), "what to do when a client queue is full - dropoldest, coalesce or disconnect")
+        ("ratelimit", po::value<double>(&m_rateLimit), "maximum requests per second for a client - 0 for unlimited")
+        ("rateburst", po::value<double>(&m_rateBurst), "maximum requests a client may make at once")
+        ("methodratelimit", po::value<std::vector<std::string>>(&m_methodRateLimitStrs), "maximum requests per second for a client calling a method - method:rate[:burst]")
+        ("maxpendingcommands", po::value<uint32_t>(&m_maxPendingCommands), "maximum number of queued commands before requests are rejected - 0 for unlimited")
+        ("requesttimeout", po::value<uint32_t>(&m_requestTimeout), "default request timeout in milliseconds - 0 for none")
+        ("idempotencykeys", po::value<uint32_t>(&m_idempotencyKeys), "number of idempotency keys whose results are remembered")
+        ("coalescewindow", po::value<std::vector<std::string>>(&m_coalesceWindowStrs), "merge tx updates on a channel or channel set within a window - channel:milliseconds")
+        ("replayevents", po::value<uint32_t>(&m_replayEvents), "number of recent channel events kept for resuming subscribers - 0 to disable")
+        ("replayretain", po::value<uint32_t>(&m_replayRetain), "seconds a channel keeps being rendered for resuming subscribers after its last one leaves")
+        ("compressthreshold", po::value<uint32_t>(&m_compressThreshold), "smallest message in bytes deflated for clients that enable compression")
+        ("finalitytxs", po::value<uint32_t>(&m_finalityTxs), "maximum number of confirmed txs awaiting finality - 0 for unlimited")
+        ("merkleblockbatch", po::value<uint32_t>(&m_merkleBlockBatch), "while syncing, summarize this many merkle blocks per merkleblocksinserted event - 0 to send every block")
+        ("merkleblockbatchwindow", po::value<uint32_t>(&m_merkleBlockBatchWindow), "while syncing, longest time in milliseconds a merkle block summary is held")
+        ("addresscache", po::value<uint32_t>(&m_addressCache), "number of txout script addresses kept rendered - 0 to disable")
+        ("txjsoncache", po::value<uint32_t>(&m_txJsonCache), "number of rendered txs kept for json events - 0 to disable")
+        ("loglevel", po::value<std::string>(&m_logLevelStr), "least severe level of request and event messages logged - trace, debug, info or error")
     ;
 
     po::variables_map vm;
@@ -197,5 +302,53 @@ inline void CoinSocketConfig::init(int argc, char* argv[])
     if (!vm.count("wsport"))        { m_webSocketPort = DEFAULT_WEBSOCKET_PORT; }
     if (!vm.count("allowedips"))    { m_allowedIps = DEFAULT_ALLOWED_IPS; }
     if (!vm.count("minconf"))       { m_minConf = DEFAULT_MIN_CONF; }
+    if (!vm.count("commandthreads")) { m_commandThreads = DEFAULT_COMMAND_THREADS; }
+    if (!vm.count("jobthreads"))    { m_jobThreads = DEFAULT_JOB_THREADS; }
+    if (!vm.count("outqueuemessages")) { m_outQueueMessages = DEFAULT_OUTQUEUE_MESSAGES; }
+    if (!vm.count("outqueuebytes")) { m_outQueueBytes = DEFAULT_OUTQUEUE_BYTES; }
+    if (!vm.count("outqueuepolicy")) { m_outQueuePolicy = DEFAULT_OUTQUEUE_POLICY; }
+
+    // A zero limit would leave every client permanently over it.
+    if (m_outQueueMessages == 0 || m_outQueueBytes == 0) throw CoinSocket::ConfigInvalidOutQueueLimitException();
+
+    CoinSocket::OverflowPolicy outQueuePolicy;
+    std::transform(m_outQueuePolicy.begin(), m_outQueuePolicy.end(), m_outQueuePolicy.begin(), ::tolower);
+    if (!CoinSocket::getOverflowPolicy(m_outQueuePolicy, outQueuePolicy)) throw CoinSocket::ConfigInvalidOutQueuePolicyException();
+
+    if (!vm.count("ratelimit"))     { m_rateLimit = 0; }
+    if (!vm.count("rateburst"))     { m_rateBurst = 0; }
+    if (!vm.count("maxpendingcommands")) { m_maxPendingCommands = DEFAULT_MAX_PENDING_COMMANDS; }
+    if (!vm.count("requesttimeout")) { m_requestTimeout = DEFAULT_REQUEST_TIMEOUT; }
+    if (!vm.count("idempotencykeys")) { m_idempotencyKeys = DEFAULT_IDEMPOTENCY_KEYS; }
+    if (!vm.count("replayevents"))  { m_replayEvents = DEFAULT_REPLAY_EVENTS; }
+    if (!vm.count("replayretain"))  { m_replayRetain = DEFAULT_REPLAY_RETAIN; }
+    if (!vm.count("compressthreshold")) { m_compressThreshold = DEFAULT_COMPRESS_THRESHOLD; }
+    if (!vm.count("finalitytxs"))   { m_finalityTxs = DEFAULT_FINALITY_TXS; }
+    if (!vm.count("merkleblockbatch")) { m_merkleBlockBatch = DEFAULT_MERKLE_BLOCK_BATCH; }
+    if (!vm.count("merkleblockbatchwindow")) { m_merkleBlockBatchWindow = DEFAULT_MERKLE_BLOCK_BATCH_WINDOW; }
+    if (!vm.count("addresscache"))  { m_addressCache = DEFAULT_ADDRESS_CACHE; }
+    if (!vm.count("txjsoncache"))   { m_txJsonCache = DEFAULT_TX_JSON_CACHE; }
+    if (!vm.count("loglevel"))      { m_logLevelStr = DEFAULT_LOG_LEVEL; }
+
+    std::transform(m_logLevelStr.begin(), m_logLevelStr.end(), m_logLevelStr.begin(), ::tolower);
+    if (!getLogLevel(m_logLevelStr, m_logLevel)) throw CoinSocket::ConfigInvalidLogLevelException();
+
+    m_coalesceWindows.clear();
+    for (auto& str: m_coalesceWindowStrs)
+    {
+        std::string channel;
+        uint32_t window;
+        if (!CoinSocket::getCoalesceWindow(str, channel, window)) throw CoinSocket::ConfigInvalidCoalesceWindowException();
+        m_coalesceWindows[channel] = window;
+    }
+
+    m_methodRateLimits.clear();
+    for (auto& str: m_methodRateLimitStrs)
+    {
+        std::string method;
+        CoinSocket::RateLimit limit;
+        if (!CoinSocket::getMethodRateLimit(str, method, limit)) throw CoinSocket::ConfigInvalidMethodRateLimitException();
+        m_methodRateLimits[method] = limit;
+    }
 }
 
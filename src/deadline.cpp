@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// deadline.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "deadline.h"
+#include "config.h"
+#include "CoinSocketExceptions.h"
+
+#include <map>
+#include <mutex>
+
+using namespace CoinSocket;
+using namespace std;
+
+static mutex g_timeoutMutex;
+static map<websocketpp::connection_hdl, uint32_t, owner_less<websocketpp::connection_hdl>> g_timeouts;
+
+static thread_local DeadlineScope* g_currentDeadline = nullptr;
+
+void CoinSocket::setRequestTimeout(websocketpp::connection_hdl hdl, uint32_t timeout)
+{
+    // The connection may have closed, and its entry been removed, while the
+    // command was queued.
+    if (hdl.expired()) return;
+
+    lock_guard<mutex> lock(g_timeoutMutex);
+    g_timeouts[hdl] = timeout;
+}
+
+uint32_t CoinSocket::getRequestTimeout(websocketpp::connection_hdl hdl)
+{
+    lock_guard<mutex> lock(g_timeoutMutex);
+    auto it = g_timeouts.find(hdl);
+    return it != g_timeouts.end() ? it->second : getConfig().getRequestTimeout();
+}
+
+void CoinSocket::removeRequestTimeout(websocketpp::connection_hdl hdl)
+{
+    lock_guard<mutex> lock(g_timeoutMutex);
+    g_timeouts.erase(hdl);
+}
+
+deadline_t CoinSocket::getRequestDeadline(websocketpp::connection_hdl hdl)
+{
+    uint32_t timeout = getRequestTimeout(hdl);
+    if (timeout == 0) return deadline_t::max();
+
+    return chrono::steady_clock::now() + chrono::milliseconds(timeout);
+}
+
+DeadlineScope::DeadlineScope(websocketpp::connection_hdl hdl, deadline_t deadline)
+    : m_hdl(hdl), m_deadline(deadline), m_parent(g_currentDeadline)
+{
+    g_currentDeadline = this;
+}
+
+DeadlineScope::~DeadlineScope()
+{
+    g_currentDeadline = m_parent;
+}
+
+void DeadlineScope::check() const
+{
+    if (m_hdl.expired()) throw OperationCanceledException();
+    if (m_deadline != deadline_t::max() && chrono::steady_clock::now() > m_deadline) throw OperationDeadlineExceededException();
+}
+
+void CoinSocket::checkDeadline()
+{
+    if (g_currentDeadline) { g_currentDeadline->check(); }
+}
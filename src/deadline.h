@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// deadline.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <WebSocketAPI/Server.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+typedef std::chrono::steady_clock::time_point deadline_t;
+
+// Per-connection request timeout in milliseconds. Zero means no timeout.
+void setRequestTimeout(websocketpp::connection_hdl hdl, uint32_t timeout);
+uint32_t getRequestTimeout(websocketpp::connection_hdl hdl);
+void removeRequestTimeout(websocketpp::connection_hdl hdl);
+
+// Deadline for a request from the connection arriving now.
+deadline_t getRequestDeadline(websocketpp::connection_hdl hdl);
+
+// Marks the calling thread as working on a request for the connection for
+// the lifetime of the scope.
+class DeadlineScope
+{
+public:
+    DeadlineScope(websocketpp::connection_hdl hdl, deadline_t deadline);
+    ~DeadlineScope();
+
+    void check() const;
+
+private:
+    websocketpp::connection_hdl m_hdl;
+    deadline_t m_deadline;
+    DeadlineScope* m_parent;
+};
+
+// Called by command handlers at safe points. Throws if the current request's
+// deadline has passed or its connection has closed.
+void checkDeadline();
+
+}
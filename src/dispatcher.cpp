@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// dispatcher.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "dispatcher.h"
+#include "coalescer.h"
+
+#include <logger/logger.h>
+
+#include <algorithm>
+
+using namespace CoinSocket;
+using namespace CoinDB;
+using namespace json_spirit;
+using namespace std;
+
+static EventDispatcher g_eventDispatcher;
+
+EventDispatcher& CoinSocket::getEventDispatcher()
+{
+    return g_eventDispatcher;
+}
+
+void EventDispatcher::start(WebSocket::Server& server, SynchedVault& synchedVault)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_bRunning) return;
+
+    m_server = &server;
+    m_synchedVault = &synchedVault;
+    m_bRunning = true;
+    m_thread = thread(&EventDispatcher::run, this);
+}
+
+void EventDispatcher::stop()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_bRunning) return;
+        m_bRunning = false;
+    }
+
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void EventDispatcher::postTx(TxEventType type, shared_ptr<Tx> tx, bool fakeFinal)
+{
+    Event event;
+    event.kind = Event::TX;
+    event.txType = type;
+    event.bFakeFinal = fakeFinal;
+    event.tx = tx;
+    post(move(event));
+}
+
+void EventDispatcher::postStatus()
+{
+    Event event;
+    event.kind = Event::STATUS;
+    post(move(event));
+}
+
+void EventDispatcher::postMerkleBlock(shared_ptr<MerkleBlock> merkleBlock)
+{
+    Event event;
+    event.kind = Event::MERKLE_BLOCK;
+    event.merkleBlock = merkleBlock;
+    post(move(event));
+}
+
+Object EventDispatcher::getMetricsObject()
+{
+    Object result;
+    result.push_back(Pair("depth", m_depth.load()));
+    result.push_back(Pair("maxdepth", m_maxDepth.load()));
+    result.push_back(Pair("published", m_published.load()));
+    return result;
+}
+
+void EventDispatcher::post(Event event)
+{
+    // Counted before the push so the depth can never go negative.
+    uint64_t depth = m_depth.fetch_add(1) + 1;
+    m_queue.push(move(event));
+
+    uint64_t maxDepth = m_maxDepth.load(memory_order_relaxed);
+    while (depth > maxDepth && !m_maxDepth.compare_exchange_weak(maxDepth, depth, memory_order_relaxed));
+
+    // The publisher announces when it is about to sleep, so the lock is only
+    // taken when it actually needs waking.
+    if (m_bSleeping)
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_cond.notify_one();
+    }
+}
+
+void EventDispatcher::publish(Event& event)
+{
+    switch (event.kind)
+    {
+    case Event::TX:
+        sendTxChannelEvent(event.txType, *m_server, *m_synchedVault, event.tx, event.bFakeFinal);
+        break;
+    case Event::STATUS:
+        sendStatusEvent(*m_server, *m_synchedVault);
+        break;
+    case Event::MERKLE_BLOCK:
+        sendMerkleBlockEvent(*m_server, *m_synchedVault, event.merkleBlock);
+        break;
+    }
+}
+
+void EventDispatcher::run()
+{
+    Event event;
+    chrono::steady_clock::time_point batchDue = chrono::steady_clock::time_point::max();
+    chrono::steady_clock::time_point coalesceDue = chrono::steady_clock::time_point::max();
+    while (true)
+    {
+        // A merkle block summary or a coalesced update must go out when its
+        // window closes even if no further event arrives.
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if (now >= batchDue)    { batchDue = flushDueMerkleBlockBatch(); }
+        if (now >= coalesceDue) { coalesceDue = getEventCoalescer().flush(); }
+
+        if (m_queue.pop(event))
+        {
+            m_depth--;
+            try
+            {
+                publish(event);
+            }
+            catch (const exception& e)
+            {
+                LOGGER(error) << "EventDispatcher publish error: " << e.what() << endl;
+            }
+            m_published++;
+            if (event.kind == Event::MERKLE_BLOCK)  { batchDue = flushDueMerkleBlockBatch(); }
+            if (event.kind == Event::TX)            { coalesceDue = getEventCoalescer().flush(); }
+            event = Event();
+            continue;
+        }
+
+        unique_lock<mutex> lock(m_mutex);
+        if (!m_bRunning) break;
+
+        chrono::steady_clock::time_point due = min(batchDue, coalesceDue);
+        m_bSleeping = true;
+        if (due == chrono::steady_clock::time_point::max()) { m_cond.wait(lock, [this]() { return !m_bRunning || m_depth > 0; }); }
+        else                                                { m_cond.wait_until(lock, due, [this]() { return !m_bRunning || m_depth > 0; }); }
+        m_bSleeping = false;
+    }
+
+    // Updates and a merkle block summary still held back are sent rather
+    // than lost.
+    getEventCoalescer().flush(true);
+    flushDueMerkleBlockBatch(true);
+}
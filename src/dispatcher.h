@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// dispatcher.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include "events.h"
+#include "mpscqueue.h"
+
+#include <CoinDB/SynchedVault.h>
+#include <WebSocketAPI/Server.h>
+#include <json_spirit/json_spirit_value.h>
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Vault callbacks only queue a record of what happened. A publisher thread
+// renders and fans out the events in the order they were queued, so slow
+// subscribers cannot hold up blockchain sync.
+class EventDispatcher
+{
+public:
+    EventDispatcher() : m_server(nullptr), m_synchedVault(nullptr), m_bRunning(false), m_bSleeping(false), m_depth(0), m_maxDepth(0), m_published(0) { }
+    ~EventDispatcher() { stop(); }
+
+    void start(WebSocket::Server& server, CoinDB::SynchedVault& synchedVault);
+
+    // Publishes everything already queued before returning.
+    void stop();
+
+    void postTx(TxEventType type, std::shared_ptr<CoinDB::Tx> tx, bool fakeFinal = false);
+    void postStatus();
+    void postMerkleBlock(std::shared_ptr<CoinDB::MerkleBlock> merkleBlock);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    struct Event
+    {
+        enum kind_t { TX, STATUS, MERKLE_BLOCK };
+
+        Event() : kind(STATUS), txType(UPDATED), bFakeFinal(false) { }
+
+        kind_t kind;
+        TxEventType txType;
+        bool bFakeFinal;
+        std::shared_ptr<CoinDB::Tx> tx;
+        std::shared_ptr<CoinDB::MerkleBlock> merkleBlock;
+    };
+
+    WebSocket::Server* m_server;
+    CoinDB::SynchedVault* m_synchedVault;
+
+    MpscQueue<Event> m_queue;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::atomic<bool> m_bRunning;
+    std::atomic<bool> m_bSleeping;
+    std::thread m_thread;
+
+    std::atomic<uint64_t> m_depth;
+    std::atomic<uint64_t> m_maxDepth;
+    std::atomic<uint64_t> m_published;
+
+    void post(Event event);
+    void publish(Event& event);
+    void run();
+};
+
+EventDispatcher& getEventDispatcher();
+
+}
@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// encoding.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "encoding.h"
+
+#include <mutex>
+#include <cstring>
+
+using namespace CoinSocket;
+using namespace json_spirit;
+using namespace std;
+
+enum CborMajorType
+{
+    CBOR_UNSIGNED   = 0,
+    CBOR_NEGATIVE   = 1,
+    CBOR_BYTES      = 2,
+    CBOR_TEXT       = 3,
+    CBOR_ARRAY      = 4,
+    CBOR_MAP        = 5
+};
+
+const unsigned char CBOR_FALSE  = 0xf4;
+const unsigned char CBOR_TRUE   = 0xf5;
+const unsigned char CBOR_NULL   = 0xf6;
+const unsigned char CBOR_DOUBLE = 0xfb;
+
+static const set<string> BYTE_STRING_KEYS =
+{
+    "hash", "unsignedhash", "outhash", "prevhash", "merkleroot", "synchash", "besthash",
+    "script", "rawtx", "pubkey", "proposalid"
+};
+
+static mutex g_encodingMutex;
+static BinaryConnections g_binaryConnections;
+
+bool CoinSocket::getEncoding(const string& name, Encoding& encoding)
+{
+    if      (name == "json")    { encoding = ENCODING_JSON; }
+    else if (name == "cbor")    { encoding = ENCODING_CBOR; }
+    else                        { return false; }
+    return true;
+}
+
+void CoinSocket::setConnectionEncoding(websocketpp::connection_hdl hdl, Encoding encoding)
+{
+    if (hdl.expired()) return;
+
+    lock_guard<mutex> lock(g_encodingMutex);
+    if (encoding == ENCODING_CBOR)  { g_binaryConnections.insert(hdl); }
+    else                            { g_binaryConnections.erase(hdl); }
+}
+
+Encoding CoinSocket::getConnectionEncoding(websocketpp::connection_hdl hdl)
+{
+    lock_guard<mutex> lock(g_encodingMutex);
+    return g_binaryConnections.count(hdl) ? ENCODING_CBOR : ENCODING_JSON;
+}
+
+void CoinSocket::removeConnectionEncoding(websocketpp::connection_hdl hdl)
+{
+    lock_guard<mutex> lock(g_encodingMutex);
+    g_binaryConnections.erase(hdl);
+}
+
+bool CoinSocket::hasBinaryConnections()
+{
+    lock_guard<mutex> lock(g_encodingMutex);
+    return !g_binaryConnections.empty();
+}
+
+BinaryConnections CoinSocket::getBinaryConnections()
+{
+    lock_guard<mutex> lock(g_encodingMutex);
+    return g_binaryConnections;
+}
+
+static void appendCborHead(string& out, CborMajorType type, uint64_t n)
+{
+    unsigned char major = type << 5;
+    if (n < 24)
+    {
+        out += (char)(major | n);
+        return;
+    }
+
+    int bytes;
+    if      (n <= 0xff)         { out += (char)(major | 24); bytes = 1; }
+    else if (n <= 0xffff)       { out += (char)(major | 25); bytes = 2; }
+    else if (n <= 0xffffffff)   { out += (char)(major | 26); bytes = 4; }
+    else                        { out += (char)(major | 27); bytes = 8; }
+
+    for (int i = bytes - 1; i >= 0; i--) { out += (char)((n >> (8 * i)) & 0xff); }
+}
+
+static void appendCborText(string& out, const string& text)
+{
+    appendCborHead(out, CBOR_TEXT, text.size());
+    out += text;
+}
+
+static int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Writes hex as a byte string, or returns false if it isn't hex.
+static bool appendCborHexBytes(string& out, const string& hex)
+{
+    if (hex.size() % 2) return false;
+    for (char c: hex) { if (hexDigit(c) < 0) return false; }
+
+    appendCborHead(out, CBOR_BYTES, hex.size() / 2);
+    for (size_t i = 0; i < hex.size(); i += 2) { out += (char)((hexDigit(hex[i]) << 4) | hexDigit(hex[i + 1])); }
+    return true;
+}
+
+static void appendCborValue(string& out, const Value& value, bool bBytes)
+{
+    switch (value.type())
+    {
+    case obj_type:
+    {
+        const Object& obj = value.get_obj();
+        appendCborHead(out, CBOR_MAP, obj.size());
+        for (auto& pair: obj)
+        {
+            appendCborText(out, pair.name_);
+            appendCborValue(out, pair.value_, BYTE_STRING_KEYS.count(pair.name_) > 0);
+        }
+        break;
+    }
+    case array_type:
+    {
+        const Array& array = value.get_array();
+        appendCborHead(out, CBOR_ARRAY, array.size());
+        for (auto& item: array) { appendCborValue(out, item, false); }
+        break;
+    }
+    case str_type:
+        if (!bBytes || !appendCborHexBytes(out, value.get_str())) { appendCborText(out, value.get_str()); }
+        break;
+    case bool_type:
+        out += (char)(value.get_bool() ? CBOR_TRUE : CBOR_FALSE);
+        break;
+    case int_type:
+        if (value.is_uint64())
+        {
+            appendCborHead(out, CBOR_UNSIGNED, value.get_uint64());
+        }
+        else
+        {
+            int64_t n = value.get_int64();
+            if (n >= 0) { appendCborHead(out, CBOR_UNSIGNED, (uint64_t)n); }
+            else        { appendCborHead(out, CBOR_NEGATIVE, (uint64_t)(-1 - n)); }
+        }
+        break;
+    case real_type:
+    {
+        double d = value.get_real();
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        out += (char)CBOR_DOUBLE;
+        for (int i = 7; i >= 0; i--) { out += (char)((bits >> (8 * i)) & 0xff); }
+        break;
+    }
+    default:
+        out += (char)CBOR_NULL;
+    }
+}
+
+void CoinSocket::appendCbor(string& out, const Value& value)
+{
+    appendCborValue(out, value, false);
+}
+
+payload_ptr CoinSocket::makeCborPayload(const Value& value)
+{
+    string cbor;
+    appendCbor(cbor, value);
+    return make_shared<const string>(move(cbor));
+}
+
+payload_ptr CoinSocket::makeCborEventPayload(const string& channel, uint64_t seq, const string& dataCbor)
+{
+    string cbor;
+    appendCborHead(cbor, CBOR_MAP, 3);
+    appendCborText(cbor, "event");
+    appendCborText(cbor, channel);
+    appendCborText(cbor, "seq");
+    appendCborHead(cbor, CBOR_UNSIGNED, seq);
+    appendCborText(cbor, "data");
+    cbor += dataCbor;
+    return make_shared<const string>(move(cbor));
+}
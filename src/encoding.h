@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// encoding.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include "outbound.h"
+
+#include <json_spirit/json_spirit_value.h>
+#include <WebSocketAPI/Server.h>
+
+#include <string>
+#include <set>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// How tx events and command results are framed for a connection. With CBOR
+// (RFC 7049) hashes, scripts and raw txs travel as byte strings instead of
+// hex, and each message is sent as a binary frame. Events that are not tx
+// events, such as status and job events, stay JSON in text frames.
+enum Encoding
+{
+    ENCODING_JSON,
+    ENCODING_CBOR
+};
+
+bool getEncoding(const std::string& name, Encoding& encoding);
+
+typedef std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> BinaryConnections;
+
+void setConnectionEncoding(websocketpp::connection_hdl hdl, Encoding encoding);
+Encoding getConnectionEncoding(websocketpp::connection_hdl hdl);
+void removeConnectionEncoding(websocketpp::connection_hdl hdl);
+bool hasBinaryConnections();
+BinaryConnections getBinaryConnections();
+
+// Hex strings under keys such as "hash", "script" and "rawtx" are written as
+// byte strings. Everything else maps onto the corresponding CBOR type.
+void appendCbor(std::string& out, const json_spirit::Value& value);
+
+// Payloads to send with bBinary set.
+payload_ptr makeCborPayload(const json_spirit::Value& value);
+
+// {"event":channel, "seq":seq, "data":data} around data already in CBOR.
+payload_ptr makeCborEventPayload(const std::string& channel, uint64_t seq, const std::string& dataCbor);
+
+}
@@ -18,7 +18,16 @@
 #include <logger/logger.h>
 
 #include "config.h"
+#include "channels.h"
+#include "filter.h"
+#include "coalescer.h"
+#include "finality.h"
+#include "encoding.h"
+#include "hex.h"
+#include "replay.h"
+#include "outbound.h"
 #include "jsonobjects.h"
+#include "txjsoncache.h"
 #include "txproposal.h"
 
 #include <string>
@@ -35,14 +44,74 @@ using namespace WebSocket;
 using namespace CoinDB;
 using namespace std;
 
-static multimap<uint32_t, shared_ptr<Tx>> g_pendingTxs;
-static set<bytes_t> g_pendingTxHashes;
+// Merkle blocks inserted while catching up, summarized instead of sent one
+// by one. Only touched from the event publisher thread.
+struct MerkleBlockBatch
+{
+    MerkleBlockBatch() : maxBlocks(0), window(0), count(0) { }
+
+    uint32_t maxBlocks;
+    chrono::milliseconds window;
+
+    uint32_t count;
+    chrono::steady_clock::time_point start;
+    shared_ptr<BlockHeader> first;
+    shared_ptr<BlockHeader> last;
+};
+
+static MerkleBlockBatch g_merkleBlockBatch;
+
+static void flushMerkleBlockBatch()
+{
+    using namespace json_spirit;
+
+    MerkleBlockBatch& batch = g_merkleBlockBatch;
+    if (batch.count == 0) return;
+
+    Object batchData;
+    batchData.push_back(Pair("count", (uint64_t)batch.count));
+    batchData.push_back(Pair("first", getBlockHeaderObject(*batch.first)));
+    batchData.push_back(Pair("last", getBlockHeaderObject(*batch.last)));
+    publishChannelEvent("merkleblocksinserted", batchData);
 
-multimap<uint32_t, shared_ptr<Tx>>& CoinSocket::getPendingTxs() { return g_pendingTxs; }
-set<bytes_t>& CoinSocket::getPendingTxHashes() { return g_pendingTxHashes; } 
+    batch.count = 0;
+    batch.first.reset();
+    batch.last.reset();
+}
 
 // TODO: Clean up the txapprovedjson and txrejectedjson mess
 
+// Reused by each thread that renders events so its buffer stays allocated.
+static JsonWriter& getEventWriter()
+{
+    static thread_local JsonWriter writer;
+    return writer;
+}
+
+// The data of a json tx event: the tx, its asset type and finality and, for
+// approvals and rejections, the proposal.
+static void writeTxEventJson(JsonWriter& writer, const Tx& tx, bool bFinal, const TxProposal* txProposal)
+{
+    using namespace json_spirit;
+
+    writer.beginObject();
+    writer.members(*getTxJsonCache().getTxMembers(tx));
+    writer.key("assettype").value(getConfig().getCoinParams().currency_symbol());
+    writer.key("final").value(bFinal);
+    if (txProposal) { writer.key("proposal").json(write_string<Value>(getTxProposalObject(*txProposal))); }
+    writer.endObject();
+}
+
+static string makeTxJsonEvent(const char* eventName, const string& dataJson)
+{
+    string msg("{\"event\":\"");
+    msg += eventName;
+    msg += "\", \"data\":";
+    msg += dataJson;
+    msg += "}";
+    return msg;
+}
+
 void CoinSocket::sendTxJsonEvent(TxEventType type, WebSocket::Server& wsServer, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, std::shared_ptr<CoinDB::Tx>& tx, bool fakeFinal)
 {
     using namespace json_spirit;
@@ -51,7 +120,7 @@ void CoinSocket::sendTxJsonEvent(TxEventType type, WebSocket::Server& wsServer,
     {
         bytes_t unsigned_hash = tx->unsigned_hash();
         Tx::status_t status = tx->status();
-        string hash = uchar_vector(tx->hash()).getHex();
+        string hash = toHex(tx->hash());
         string statusstr = Tx::getStatusString(status);
         //uint32_t confirmations = synchedVault.getVault()->getTxConfirmations(tx);
         uint32_t height = tx->blockheader() ? tx->blockheader()->height() : 0;
@@ -81,72 +150,37 @@ void CoinSocket::sendTxJsonEvent(TxEventType type, WebSocket::Server& wsServer,
             break;
         }
 
+        const char* eventName;
+        switch (type)
         {
-/*
-            Value txVal;
-            if (!read_string(tx->toJson(false), txVal) || txVal.type() != obj_type) throw InternalTxJsonInvalidException();
-            Object txObj = txVal.get_obj();
-*/
-            Object txObj = getTxObject(*tx);
-            txObj.push_back(Pair("assettype", getConfig().getCoinParams().currency_symbol()));
-            txObj.push_back(Pair("final", bFinal));
+        case INSERTED:  eventName = "txinsertedjson"; break;
+        case UPDATED:   eventName = "txupdatedjson"; break;
+        case APPROVED:  eventName = "txapprovedjson"; break;
+        case CANCELED:  eventName = "txcanceledjson"; break;
+        case REJECTED:  eventName = "txrejectedjson"; break;
+        case DELETED:   eventName = "txdeletedjson"; break;
+        default:        return;
+        }
 
-            //txObj.push_back(Pair("confirmations", (uint64_t)confirmations));
-            stringstream msg;
-            switch (type)
-            {
-            case INSERTED:
-                msg << "{\"event\":\"txinsertedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.send(hdl, msg.str());
-                break;
-            case UPDATED:
-                msg << "{\"event\":\"txupdatedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.send(hdl, msg.str());
-                break;
-            case APPROVED:
-                msg << "{\"event\":\"txapprovedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.send(hdl, msg.str());
-                break;
-            case CANCELED:
-                msg << "{\"event\":\"txcanceledjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.send(hdl, msg.str());
-                break;
-            case REJECTED:
-                msg << "{\"event\":\"txrejectedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.send(hdl, msg.str());
-                break;
-            case DELETED:
-                msg << "{\"event\":\"txdeletedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.send(hdl, msg.str());
-                break;
-            default:
-                break;
-            }
+        JsonWriter& writer = getEventWriter();
+        writer.clear();
+        writeTxEventJson(writer, *tx, bFinal, nullptr);
+        getOutbound().sendEvent(hdl, makeTxJsonEvent(eventName, writer.str()));
 
-            if (type == INSERTED || type == UPDATED || type == DELETED)
+        if (type == INSERTED || type == UPDATED || type == DELETED)
+        {
+            shared_ptr<TxProposal> txProposal = getProcessedTxSubmission(tx->unsigned_hash());
+            if (txProposal)
             {
-                shared_ptr<TxProposal> txProposal = getProcessedTxSubmission(tx->unsigned_hash());
-                if (txProposal)
+                const char* proposalEventName = nullptr;
+                if (type == DELETED)                                            { proposalEventName = "txrejectedjson"; }
+                else if (status == Tx::PROPAGATED || status == Tx::CONFIRMED)   { proposalEventName = "txapprovedjson"; }
+
+                if (proposalEventName)
                 {
-                    txObj.push_back(Pair("proposal", getTxProposalObject(*txProposal)));
-                    stringstream msg;
-                    switch (type)
-                    {
-                    case INSERTED:
-                    case UPDATED:
-                        if (status == Tx::PROPAGATED || status == Tx::CONFIRMED)
-                        {
-                            msg << "{\"event\":\"txapprovedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                            wsServer.send(hdl, msg.str());
-                        }
-                        break;
-                    case DELETED:
-                        msg << "{\"event\":\"txrejectedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                        wsServer.send(hdl, msg.str());
-                        break;
-                    default:
-                        break;
-                    }
+                    writer.clear();
+                    writeTxEventJson(writer, *tx, bFinal, txProposal.get());
+                    getOutbound().sendEvent(hdl, makeTxJsonEvent(proposalEventName, writer.str()));
                 }
             }
         }
@@ -157,23 +191,27 @@ void CoinSocket::sendTxJsonEvent(TxEventType type, WebSocket::Server& wsServer,
     }
 }
 
+// Tx attributes are only worked out when something can filter on them: a
+// subscriber with a filter, or the replay ring, since a replayed event may go
+// to a subscription that filters.
+static bool needsTxAttributes(const string& channel)
+{
+    return isReplayEnabled() || hasSubscriptionFilters(channel);
+}
+
 void CoinSocket::sendTxChannelEvent(Server& wsServer, shared_ptr<TxProposal>& txProposal)
 {
     using namespace json_spirit;
 
     try
     {
-        Object txObj = getTxProposalObject(*txProposal);
-        stringstream msg;
         switch (txProposal->status())
         {
         case TxProposal::CANCELED:
-            msg << "{\"event\":\"txcanceledjson\", \"data\":" << write_string<Value>(txObj) << "}";
-            wsServer.sendChannel("txcanceledjson", msg.str());
+            publishChannelEvent("txcanceledjson", getTxProposalObject(*txProposal), string(), needsTxAttributes("txcanceledjson") ? getTxProposalAttributes(*txProposal) : tx_attributes_ptr());
             break;
         case TxProposal::REJECTED:
-            msg << "{\"event\":\"txrejectedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-            wsServer.sendChannel("txrejectedjson", msg.str());
+            publishChannelEvent("txrejectedjson", getTxProposalObject(*txProposal), string(), needsTxAttributes("txrejectedjson") ? getTxProposalAttributes(*txProposal) : tx_attributes_ptr());
             break;
         default:
             break;
@@ -185,68 +223,89 @@ void CoinSocket::sendTxChannelEvent(Server& wsServer, shared_ptr<TxProposal>& tx
     }
 }
 
-void CoinSocket::sendTxChannelEvent(TxEventType type, Server& wsServer, SynchedVault& synchedVault, shared_ptr<Tx>& tx, bool fakeFinal)
+enum TxVariant
+{
+    TX_VARIANT_SUMMARY      = 1,
+    TX_VARIANT_JSON         = 2,
+    TX_VARIANT_PROPOSAL     = 4,
+    TX_VARIANT_RAW          = 8,
+    TX_VARIANT_SERIALIZED   = 16,
+    TX_VARIANT_LAST         = TX_VARIANT_SERIALIZED
+};
+
+static string getTxVariantChannel(TxEventType type, const string& eventName, TxVariant variant)
+{
+    switch (variant)
+    {
+    case TX_VARIANT_SUMMARY:    return eventName;
+    case TX_VARIANT_JSON:       return eventName + "json";
+    case TX_VARIANT_PROPOSAL:   return type == DELETED ? "txrejectedjson" : "txapprovedjson";
+    case TX_VARIANT_RAW:        return eventName + "raw";
+    case TX_VARIANT_SERIALIZED: return eventName + "serialized";
+    default:                    return string();
+    }
+}
+
+// Renders each requested variant of a tx event once and sends it to its channel.
+static void sendTxVariants(TxEventType type, SynchedVault& synchedVault, shared_ptr<Tx>& tx, bool fakeFinal, unsigned int variants)
 {
     using namespace json_spirit;
 
     try
     {
-        bytes_t unsigned_hash = tx->unsigned_hash();
         Tx::status_t status = tx->status();
-        string hash = uchar_vector(tx->hash()).getHex();
-        string statusstr = Tx::getStatusString(status);
-        //uint32_t confirmations = synchedVault.getVault()->getTxConfirmations(tx);
+        string hash = toHex(tx->hash());
+        string key = toHex(tx->unsigned_hash()); // unsigned txs have no hash yet
         uint32_t height = tx->blockheader() ? tx->blockheader()->height() : 0;
         bool bFinal = fakeFinal || ((height > 0) && (synchedVault.getSyncHeight() >= height + getConfig().getMinConf() - 1));
-        if (status == Tx::CONFIRMED && !bFinal && g_pendingTxHashes.find(unsigned_hash) == g_pendingTxHashes.end())
-        {
-            g_pendingTxHashes.insert(unsigned_hash);
-            g_pendingTxs.insert(pair<uint32_t, shared_ptr<Tx>>(height, tx));
-        }
+        string eventName = type == INSERTED ? "txinserted" : (type == UPDATED ? "txupdated" : "txdeleted");
 
-        shared_ptr<TxProposal> txProposal = getProcessedTxSubmission(tx->unsigned_hash());
-
-        switch (type)
+        shared_ptr<TxProposal> txProposal;
+        if ((variants & TX_VARIANT_PROPOSAL) && (type == DELETED || status == Tx::PROPAGATED || status == Tx::CONFIRMED))
         {
-        case INSERTED:
-            LOGGER(debug) << "Transaction inserted: " << hash << " Status: " << statusstr << " Height: " << height << endl;
-            break;
-        case UPDATED:
-            LOGGER(debug) << "Transaction updated: " << hash << " Status: " << statusstr << " Height: " << height << endl;
-            break;
-        case DELETED:
-            LOGGER(debug) << "Transaction deleted: " << hash << " Status: " << statusstr << " Height: " << height << endl;
-            break;
-        default:
-            break;
+            txProposal = getProcessedTxSubmission(tx->unsigned_hash());
         }
 
         Object txData;
         txData.push_back(Pair("hash", hash));
-        txData.push_back(Pair("status", statusstr));
+        txData.push_back(Pair("status", Tx::getStatusString(status)));
         //txData.push_back(Pair("confirmations", (uint64_t)confirmations));
         txData.push_back(Pair("height", (uint64_t)height));
 
+        unsigned int channelVariants = txProposal ? (variants | TX_VARIANT_PROPOSAL) : variants;
+        bool bAttributes = false;
+        for (unsigned int variant = 1; variant <= TX_VARIANT_LAST && !bAttributes; variant <<= 1)
+        {
+            if (channelVariants & variant) { bAttributes = needsTxAttributes(getTxVariantChannel(type, eventName, (TxVariant)variant)); }
+        }
+        tx_attributes_ptr attributes;
+        if (bAttributes) { attributes = getTxAttributes(*tx); }
+
+        if (variants & TX_VARIANT_SUMMARY)
         {
-            stringstream msg;
-            switch (type)
+            string channel = getTxVariantChannel(type, eventName, TX_VARIANT_SUMMARY);
+            publishChannelEvent(channel, txData, key, attributes);
+        }
+
+        if (((variants & TX_VARIANT_JSON) || txProposal) && !hasBinaryConnections())
+        {
+            // Nothing needs the tree for CBOR, so write the text directly.
+            JsonWriter& writer = getEventWriter();
+            if (variants & TX_VARIANT_JSON)
+            {
+                writer.clear();
+                writeTxEventJson(writer, *tx, bFinal, nullptr);
+                publishChannelEventJson(getTxVariantChannel(type, eventName, TX_VARIANT_JSON), writer.str(), key, attributes);
+            }
+
+            if (txProposal)
             {
-            case INSERTED:
-                msg << "{\"event\":\"txinserted\", \"data\":" << write_string<Value>(txData) << "}";
-                wsServer.sendChannel("txinserted", msg.str());
-                break;
-            case UPDATED:
-                msg << "{\"event\":\"txupdated\", \"data\":" << write_string<Value>(txData) << "}";
-                wsServer.sendChannel("txupdated", msg.str());
-                break;
-            case DELETED:
-                msg << "{\"event\":\"txdeleted\", \"data\":" << write_string<Value>(txData) << "}";
-                wsServer.sendChannel("txdeleted", msg.str());
-                break;
-            default:
-                break;
+                writer.clear();
+                writeTxEventJson(writer, *tx, bFinal, txProposal.get());
+                publishChannelEventJson(getTxVariantChannel(type, eventName, TX_VARIANT_PROPOSAL), writer.str(), key, attributes);
             }
         }
+        else if ((variants & TX_VARIANT_JSON) || txProposal)
         {
 /*
             Value txVal;
@@ -256,92 +315,100 @@ void CoinSocket::sendTxChannelEvent(TxEventType type, Server& wsServer, SynchedV
             Object txObj = getTxObject(*tx);
             txObj.push_back(Pair("assettype", getConfig().getCoinParams().currency_symbol()));
             txObj.push_back(Pair("final", bFinal));
-
             //txObj.push_back(Pair("confirmations", (uint64_t)confirmations));
-            stringstream msg;
-            switch (type)
+
+            if (variants & TX_VARIANT_JSON)
             {
-            case INSERTED:
-                msg << "{\"event\":\"txinsertedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.sendChannel("txinsertedjson", msg.str());
-                if (txProposal && (status == Tx::PROPAGATED || status == Tx::CONFIRMED))
-                {
-                    txObj.push_back(Pair("proposal", getTxProposalObject(*txProposal)));
-                    stringstream msg;
-                    msg << "{\"event\":\"txapprovedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                    wsServer.sendChannel("txapprovedjson", msg.str());
-                }
-                break;
-            case UPDATED:
-                msg << "{\"event\":\"txupdatedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.sendChannel("txupdatedjson", msg.str());
-                if (txProposal && (status == Tx::PROPAGATED || status == Tx::CONFIRMED))
-                {
-                    txObj.push_back(Pair("proposal", getTxProposalObject(*txProposal)));
-                    stringstream msg;
-                    msg << "{\"event\":\"txapprovedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                    wsServer.sendChannel("txapprovedjson", msg.str());
-                }
-                break;
-            case DELETED:
-                msg << "{\"event\":\"txdeletedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                wsServer.sendChannel("txdeletedjson", msg.str());
-                if (txProposal)
-                {
-                    txObj.push_back(Pair("proposal", getTxProposalObject(*txProposal)));
-                    stringstream msg;
-                    msg << "{\"event\":\"txrejectedjson\", \"data\":" << write_string<Value>(txObj) << "}";
-                    wsServer.sendChannel("txrejectedjson", msg.str());
-                }
-                break;
-            default:
-                break;
+                string channel = getTxVariantChannel(type, eventName, TX_VARIANT_JSON);
+                publishChannelEvent(channel, txObj, key, attributes);
+            }
+
+            if (txProposal)
+            {
+                txObj.push_back(Pair("proposal", getTxProposalObject(*txProposal)));
+                string channel = getTxVariantChannel(type, eventName, TX_VARIANT_PROPOSAL);
+                publishChannelEvent(channel, txObj, key, attributes);
             }
         }
+
+        if (variants & TX_VARIANT_RAW)
         {
             Object rawTxData(txData);
-            rawTxData.push_back(Pair("rawtx", uchar_vector(tx->raw()).getHex()));
-            stringstream msg;
-            switch (type)
-            {
-            case INSERTED:
-                msg << "{\"event\":\"txinsertedraw\", \"data\":" << write_string<Value>(rawTxData) << "}";
-                wsServer.sendChannel("txinsertedraw", msg.str());
-                break;
-            case UPDATED:
-                msg << "{\"event\":\"txupdatedraw\", \"data\":" << write_string<Value>(rawTxData) << "}";
-                wsServer.sendChannel("txupdatedraw", msg.str());
-                break;
-            case DELETED:
-                msg << "{\"event\":\"txdeletedraw\", \"data\":" << write_string<Value>(rawTxData) << "}";
-                wsServer.sendChannel("txdeletedraw", msg.str());
-                break;
-            default:
-                break;
-            }
+            rawTxData.push_back(Pair("rawtx", toHex(tx->raw())));
+            string channel = getTxVariantChannel(type, eventName, TX_VARIANT_RAW);
+            publishChannelEvent(channel, rawTxData, key, attributes);
         }
+
+        if (variants & TX_VARIANT_SERIALIZED)
         {
             Object serializedTxData(txData);
             serializedTxData.push_back(Pair("serializedtx", tx->toSerialized()));
-            stringstream msg;
-            switch (type)
+            string channel = getTxVariantChannel(type, eventName, TX_VARIANT_SERIALIZED);
+            publishChannelEvent(channel, serializedTxData, key, attributes);
+        }
+    }
+    catch (const exception& e)
+    {
+        LOGGER(error) << "sendTxVariants() error: " << e.what() << endl;
+    }
+}
+
+void CoinSocket::sendTxChannelEvent(TxEventType type, Server& wsServer, SynchedVault& synchedVault, shared_ptr<Tx>& tx, bool fakeFinal)
+{
+    using namespace json_spirit;
+
+    try
+    {
+        bytes_t unsigned_hash = tx->unsigned_hash();
+        Tx::status_t status = tx->status();
+        //uint32_t confirmations = synchedVault.getVault()->getTxConfirmations(tx);
+        uint32_t height = tx->blockheader() ? tx->blockheader()->height() : 0;
+        bool bFinal = fakeFinal || ((height > 0) && (synchedVault.getSyncHeight() >= height + getConfig().getMinConf() - 1));
+        if (type != DELETED && status == Tx::CONFIRMED && !bFinal)  { getFinalityTracker().track(tx, height); }
+        else                                                        { getFinalityTracker().untrack(unsigned_hash); }
+
+        const char* eventName;
+        const char* action;
+        switch (type)
+        {
+        case INSERTED:  eventName = "txinserted";   action = "inserted";    break;
+        case UPDATED:   eventName = "txupdated";    action = "updated";     break;
+        case DELETED:   eventName = "txdeleted";    action = "deleted";     break;
+        default:        return;
+        }
+
+        if (getConfig().isLogged(LOG_DEBUG))
+        {
+            LOGGER(debug) << "Transaction " << action << ": " << toHex(tx->hash()) << " Status: " << Tx::getStatusString(status) << " Height: " << height << endl;
+        }
+
+        // Any update still held back is superseded by an insert or delete.
+        // Keyed by the unsigned hash, which unlike the hash is always set.
+        string key = toHex(unsigned_hash);
+        if (type != UPDATED) { getEventCoalescer().cancel(key); }
+
+        unsigned int variants = 0;
+        for (unsigned int variant = 1; variant <= TX_VARIANT_LAST; variant <<= 1)
+        {
+            string channel = getTxVariantChannel(type, eventName, (TxVariant)variant);
+            if (!isChannelLive(channel)) continue;
+
+            // Updates on channels with a coalescing window are sent once the
+            // window closes, rendered from the latest state of the tx.
+            if (type == UPDATED)
             {
-            case INSERTED:
-                msg << "{\"event\":\"txinsertedserialized\", \"data\":" << write_string<Value>(serializedTxData) << "}";
-                wsServer.sendChannel("txinsertedserialized", msg.str());
-                break;
-            case UPDATED:
-                msg << "{\"event\":\"txupdatedserialized\", \"data\":" << write_string<Value>(serializedTxData) << "}";
-                wsServer.sendChannel("txupdatedserialized", msg.str());
-                break;
-            case DELETED:
-                msg << "{\"event\":\"txdeletedserialized\", \"data\":" << write_string<Value>(serializedTxData) << "}";
-                wsServer.sendChannel("txdeletedserialized", msg.str());
-                break;
-            default:
-                break;
+                shared_ptr<Tx> latest(tx);
+                auto send = [&synchedVault, latest, fakeFinal, variant]() mutable
+                {
+                    sendTxVariants(UPDATED, synchedVault, latest, fakeFinal, variant);
+                };
+                if (getEventCoalescer().defer(channel, key, send)) continue;
             }
+
+            variants |= variant;
         }
+
+        if (variants) { sendTxVariants(type, synchedVault, tx, fakeFinal, variants); }
     }
     catch (const exception& e)
     {
@@ -351,18 +418,64 @@ void CoinSocket::sendTxChannelEvent(TxEventType type, Server& wsServer, SynchedV
 
 void CoinSocket::sendStatusEvent(Server& wsServer, SynchedVault& synchedVault)
 {
-    uint32_t finalHeight = synchedVault.getSyncHeight() + 1 - getConfig().getMinConf();
-    auto ret = getPendingTxs().equal_range(finalHeight);
-    for (auto it = ret.first; it != ret.second; ++it)
+    // Whatever was batched during catch-up goes out before the new status.
+    if (synchedVault.getStatus() == SynchedVault::SYNCHED) { flushMerkleBlockBatch(); }
+
+    uint32_t syncHeight = synchedVault.getSyncHeight();
+    uint32_t minConf = getConfig().getMinConf();
+    if (syncHeight + 1 >= minConf)
     {
-        sendTxChannelEvent(UPDATED, wsServer, synchedVault, it->second);
-        getPendingTxHashes().erase(it->second->unsigned_hash());
+        for (auto& tx: getFinalityTracker().sweep(syncHeight + 1 - minConf))
+        {
+            sendTxChannelEvent(UPDATED, wsServer, synchedVault, tx);
+        }
     }
-    getPendingTxs().erase(finalHeight);
 
     string syncStatusJson = json_spirit::write_string<json_spirit::Value>(getSyncStatusObject(synchedVault));
     LOGGER(debug) << "Status: " << syncStatusJson << endl;
-    stringstream msg;
-    msg << "{\"event\":\"status\", \"data\":" << syncStatusJson << "}";
-    wsServer.sendChannel("status", msg.str());
+    publishChannelEventJson("status", syncStatusJson, "status");
+}
+
+void CoinSocket::setMerkleBlockBatch(uint32_t maxBlocks, uint32_t window)
+{
+    g_merkleBlockBatch.maxBlocks = maxBlocks;
+    g_merkleBlockBatch.window = chrono::milliseconds(window);
+}
+
+chrono::steady_clock::time_point CoinSocket::flushDueMerkleBlockBatch(bool bForce)
+{
+    MerkleBlockBatch& batch = g_merkleBlockBatch;
+    if (batch.count == 0) return chrono::steady_clock::time_point::max();
+
+    chrono::steady_clock::time_point due = batch.start + batch.window;
+    if (!bForce && chrono::steady_clock::now() < due) return due;
+
+    flushMerkleBlockBatch();
+    return chrono::steady_clock::time_point::max();
+}
+
+void CoinSocket::sendMerkleBlockEvent(Server& wsServer, SynchedVault& synchedVault, shared_ptr<MerkleBlock>& merkleBlock)
+{
+    if (getConfig().isLogged(LOG_DEBUG))
+    {
+        LOGGER(debug) << "Merkle block inserted: " << toHex(merkleBlock->blockheader()->hash()) << " Height: " << merkleBlock->blockheader()->height() << endl;
+    }
+
+    MerkleBlockBatch& batch = g_merkleBlockBatch;
+    if (batch.maxBlocks == 0 || synchedVault.getStatus() == SynchedVault::SYNCHED)
+    {
+        flushMerkleBlockBatch();
+        publishChannelEventJson("merkleblockinserted", merkleBlock->toJson());
+        return;
+    }
+
+    if (batch.count == 0)
+    {
+        batch.start = chrono::steady_clock::now();
+        batch.first = merkleBlock->blockheader();
+    }
+    batch.last = merkleBlock->blockheader();
+    batch.count++;
+
+    if (batch.count >= batch.maxBlocks || chrono::steady_clock::now() - batch.start >= batch.window) { flushMerkleBlockBatch(); }
 }
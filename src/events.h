@@ -20,18 +20,27 @@
 #include <string>
 #include <set>
 #include <map>
+#include <chrono>
 
 namespace CoinSocket
 {
 
-// TODO: Clean this up.
-std::multimap<uint32_t, std::shared_ptr<CoinDB::Tx>>& getPendingTxs();
-std::set<bytes_t>& getPendingTxHashes();
-
 enum TxEventType { INSERTED, UPDATED, APPROVED, CANCELED, REJECTED, DELETED };
 void sendTxJsonEvent(TxEventType type, WebSocket::Server& wsServer, websocketpp::connection_hdl hdl, CoinDB::SynchedVault& synchedVault, std::shared_ptr<CoinDB::Tx>& tx, bool fakeFinal = false);
 void sendTxChannelEvent(TxEventType type, WebSocket::Server& wsServer, CoinDB::SynchedVault& synchedVault, std::shared_ptr<CoinDB::Tx>& tx, bool fakeFinal = false);
 void sendTxChannelEvent(WebSocket::Server& wsServer, std::shared_ptr<TxProposal>& txProposal);
 void sendStatusEvent(WebSocket::Server& wsServer, CoinDB::SynchedVault& synchedVault);
+void sendMerkleBlockEvent(WebSocket::Server& wsServer, CoinDB::SynchedVault& synchedVault, std::shared_ptr<CoinDB::MerkleBlock>& merkleBlock);
+
+// While the vault is not yet synched, merkle blocks are summarized on the
+// merkleblocksinserted channel once per maxBlocks blocks or window
+// milliseconds instead of being sent one by one. Zero maxBlocks disables it.
+void setMerkleBlockBatch(uint32_t maxBlocks, uint32_t window);
+
+// Publishes a held summary whose window has closed, even if no further block
+// arrives, or any held summary if forced. Returns when the summary still held
+// is due, or time_point::max() if none is held. Called from the event
+// publisher thread.
+std::chrono::steady_clock::time_point flushDueMerkleBlockBatch(bool bForce = false);
 
 }
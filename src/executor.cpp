@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// executor.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "executor.h"
+
+#include <logger/logger.h>
+
+using namespace CoinSocket;
+using namespace std;
+
+void CommandExecutor::start(unsigned int nThreads)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_bRunning) return;
+
+    if (nThreads == 0) { nThreads = 1; }
+    m_bRunning = true;
+    for (unsigned int i = 0; i < nThreads; i++)
+    {
+        m_threads.push_back(thread(&CommandExecutor::run, this));
+    }
+}
+
+void CommandExecutor::stop()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_bRunning) return;
+        m_bRunning = false;
+    }
+
+    m_cond.notify_all();
+    for (auto& t: m_threads) { t.join(); }
+    m_threads.clear();
+
+    lock_guard<mutex> lock(m_mutex);
+    m_ready.clear();
+    m_strands.clear();
+    m_pending = 0;
+}
+
+void CommandExecutor::post(websocketpp::connection_hdl hdl, task_t task)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_bRunning) return;
+
+        strand_ptr& strand = m_strands[hdl];
+        if (!strand) { strand = make_shared<Strand>(); }
+
+        strand->tasks.push_back(task);
+        m_pending++;
+        if (strand->bScheduled) return;
+
+        strand->bScheduled = true;
+        m_ready.push_back(make_pair(hdl, strand));
+    }
+
+    m_cond.notify_one();
+}
+
+size_t CommandExecutor::getPendingCount()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_pending;
+}
+
+void CommandExecutor::run()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cond.wait(lock, [this]() { return !m_bRunning || !m_ready.empty(); });
+        if (!m_bRunning) break;
+
+        websocketpp::connection_hdl hdl = m_ready.front().first;
+        strand_ptr strand = m_ready.front().second;
+        m_ready.pop_front();
+
+        task_t task = strand->tasks.front();
+        strand->tasks.pop_front();
+        m_pending--;
+
+        lock.unlock();
+        try
+        {
+            task();
+        }
+        catch (const exception& e)
+        {
+            LOGGER(error) << "CommandExecutor task error: " << e.what() << endl;
+        }
+        lock.lock();
+
+        if (strand->tasks.empty())
+        {
+            // Nothing left for this connection - drop the strand so closed
+            // connections do not accumulate.
+            strand->bScheduled = false;
+            auto it = m_strands.find(hdl);
+            if (it != m_strands.end() && it->second == strand) { m_strands.erase(it); }
+        }
+        else
+        {
+            // Requeue at the back so a busy connection cannot starve others.
+            m_ready.push_back(make_pair(hdl, strand));
+            m_cond.notify_one();
+        }
+    }
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// executor.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <WebSocketAPI/Server.h>
+
+#include <functional>
+#include <memory>
+#include <map>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace CoinSocket
+{
+
+// Runs commands on a pool of worker threads. Tasks posted for the same
+// connection are executed one at a time in the order they were posted so
+// responses to a given client are never reordered. Tasks for different
+// connections run in parallel.
+class CommandExecutor
+{
+public:
+    typedef std::function<void()> task_t;
+
+    CommandExecutor() : m_bRunning(false), m_pending(0) { }
+    ~CommandExecutor() { stop(); }
+
+    void start(unsigned int nThreads);
+    void stop();
+    bool isRunning() const { return m_bRunning; }
+
+    void post(websocketpp::connection_hdl hdl, task_t task);
+
+    // Number of tasks posted but not yet started.
+    size_t getPendingCount();
+
+private:
+    struct Strand
+    {
+        Strand() : bScheduled(false) { }
+
+        std::deque<task_t> tasks;
+        bool bScheduled;
+    };
+
+    typedef std::shared_ptr<Strand> strand_ptr;
+    typedef std::map<websocketpp::connection_hdl, strand_ptr, std::owner_less<websocketpp::connection_hdl>> strand_map_t;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_bRunning;
+    size_t m_pending;
+
+    strand_map_t m_strands;
+    std::deque<std::pair<websocketpp::connection_hdl, strand_ptr>> m_ready;
+    std::vector<std::thread> m_threads;
+
+    void run();
+};
+
+}
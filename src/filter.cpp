@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// filter.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "filter.h"
+#include "addresscache.h"
+#include "txproposal.h"
+#include "hex.h"
+#include "CoinSocketExceptions.h"
+
+#include <CoinDB/Schema.h>
+
+#include <algorithm>
+
+using namespace CoinSocket;
+using namespace CoinDB;
+using namespace json_spirit;
+using namespace std;
+
+static string toLower(string str)
+{
+    transform(str.begin(), str.end(), str.begin(), ::tolower);
+    return str;
+}
+
+// Accepts a string or an array of strings.
+static void getStrings(const Value& value, set<string>& strings, bool bLower = false)
+{
+    if (value.type() == str_type)
+    {
+        strings.insert(bLower ? toLower(value.get_str()) : value.get_str());
+        return;
+    }
+
+    if (value.type() != array_type) throw CommandInvalidParametersException();
+    for (auto& item: value.get_array())
+    {
+        if (item.type() != str_type) throw CommandInvalidParametersException();
+        strings.insert(bLower ? toLower(item.get_str()) : item.get_str());
+    }
+}
+
+tx_attributes_ptr CoinSocket::getTxAttributes(const Tx& tx)
+{
+    shared_ptr<TxAttributes> attributes = make_shared<TxAttributes>();
+    attributes->status = Tx::getStatusString(tx.status(), true);
+
+    for (auto& txout: tx.txouts())
+    {
+        TxAttributes::TxOutAttributes txoutAttributes;
+        txoutAttributes.address = getAddressCache().getAddress(txout->script());
+        txoutAttributes.script = toHex(txout->script());
+        txoutAttributes.value = txout->value();
+        if (txout->sending_account())   { txoutAttributes.sendingAccount = txout->sending_account()->name(); }
+        if (txout->receiving_account()) { txoutAttributes.receivingAccount = txout->receiving_account()->name(); }
+        attributes->txouts.push_back(txoutAttributes);
+    }
+
+    return attributes;
+}
+
+tx_attributes_ptr CoinSocket::getTxProposalAttributes(const TxProposal& txProposal)
+{
+    shared_ptr<TxAttributes> attributes = make_shared<TxAttributes>();
+    switch (txProposal.status())
+    {
+    case TxProposal::PENDING:   attributes->status = "pending"; break;
+    case TxProposal::APPROVED:  attributes->status = "approved"; break;
+    case TxProposal::CANCELED:  attributes->status = "canceled"; break;
+    case TxProposal::REJECTED:  attributes->status = "rejected"; break;
+    }
+
+    for (auto& txout: txProposal.txouts())
+    {
+        TxAttributes::TxOutAttributes txoutAttributes;
+        txoutAttributes.address = getAddressCache().getAddress(txout->script());
+        txoutAttributes.script = toHex(txout->script());
+        txoutAttributes.value = txout->value();
+        txoutAttributes.sendingAccount = txProposal.account();
+        attributes->txouts.push_back(txoutAttributes);
+    }
+
+    return attributes;
+}
+
+SubscriptionFilter::SubscriptionFilter(const Object& obj)
+    : m_minValue(0)
+{
+    for (auto& pair: obj)
+    {
+        if (pair.name_ == "account")
+        {
+            getStrings(pair.value_, m_accounts);
+        }
+        else if (pair.name_ == "addresses")
+        {
+            getStrings(pair.value_, m_addresses);
+        }
+        else if (pair.name_ == "status")
+        {
+            getStrings(pair.value_, m_statuses, true);
+        }
+        else if (pair.name_ == "minvalue")
+        {
+            if (pair.value_.type() != int_type) throw CommandInvalidParametersException();
+            m_minValue = pair.value_.get_uint64();
+        }
+        else
+        {
+            throw CommandInvalidParametersException();
+        }
+    }
+}
+
+bool SubscriptionFilter::matches(const TxAttributes* attributes) const
+{
+    if (!attributes) return false;
+
+    if (!m_statuses.empty() && !m_statuses.count(attributes->status)) return false;
+
+    bool bMatched = false;
+    uint64_t value = 0;
+    for (auto& txout: attributes->txouts)
+    {
+        if (!m_accounts.empty() && !m_accounts.count(txout.sendingAccount) && !m_accounts.count(txout.receivingAccount)) continue;
+        if (!m_addresses.empty() && !m_addresses.count(txout.address) && !m_addresses.count(txout.script)) continue;
+
+        bMatched = true;
+        value += txout.value;
+    }
+
+    if (m_accounts.empty() && m_addresses.empty()) { bMatched = true; }
+    return bMatched && value >= m_minValue;
+}
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// filter.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <json_spirit/json_spirit_value.h>
+
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <cstdint>
+
+namespace CoinDB
+{
+    class Tx;
+}
+
+namespace CoinSocket
+{
+
+class TxProposal;
+
+// What subscription filters can match on, computed once per tx event.
+struct TxAttributes
+{
+    struct TxOutAttributes
+    {
+        std::string address;
+        std::string script;
+        uint64_t value;
+        std::string sendingAccount;
+        std::string receivingAccount;
+    };
+
+    std::string status;
+    std::vector<TxOutAttributes> txouts;
+};
+
+typedef std::shared_ptr<const TxAttributes> tx_attributes_ptr;
+
+tx_attributes_ptr getTxAttributes(const CoinDB::Tx& tx);
+// The proposal's account sends each of its txouts.
+tx_attributes_ptr getTxProposalAttributes(const TxProposal& txProposal);
+
+// Server-side predicates for a subscription. A tx matches if its status is
+// allowed and the txouts belonging to the given accounts and addresses add up
+// to at least minvalue. Every event on a tx channel carries attributes; one
+// that somehow does not never matches. Filters only apply on tx channels.
+class SubscriptionFilter
+{
+public:
+    // {"account":name or [names], "addresses":[addresses or script hex],
+    //  "status":status or [statuses], "minvalue":satoshis}
+    explicit SubscriptionFilter(const json_spirit::Object& obj);
+
+    bool matches(const TxAttributes* attributes) const;
+
+private:
+    std::set<std::string> m_accounts;
+    std::set<std::string> m_addresses;
+    std::set<std::string> m_statuses;
+    uint64_t m_minValue;
+};
+
+typedef std::shared_ptr<const SubscriptionFilter> filter_ptr;
+
+inline bool filterMatches(const filter_ptr& filter, const TxAttributes* attributes)
+{
+    return !filter || filter->matches(attributes);
+}
+
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// finality.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "finality.h"
+#include "hex.h"
+
+#include <logger/logger.h>
+
+using namespace CoinSocket;
+using namespace CoinDB;
+using namespace json_spirit;
+using namespace std;
+
+void FinalityTracker::setMaxSize(size_t maxSize)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_maxSize = maxSize;
+}
+
+void FinalityTracker::track(const shared_ptr<Tx>& tx, uint32_t height)
+{
+    bytes_t unsignedHash = tx->unsigned_hash();
+
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_txs.find(unsignedHash);
+    if (it != m_txs.end())
+    {
+        it->second.tx = tx;
+        if (it->second.height == height) return;
+
+        // Confirmed in a different block - wait for that one instead.
+        m_heights.erase(height_key_t(it->second.height, unsignedHash));
+        m_heights.insert(height_key_t(height, unsignedHash));
+        it->second.height = height;
+        m_requeued++;
+        return;
+    }
+
+    Entry entry;
+    entry.height = height;
+    entry.tx = tx;
+    m_txs[unsignedHash] = entry;
+    m_heights.insert(height_key_t(height, unsignedHash));
+
+    while (m_maxSize > 0 && m_txs.size() > m_maxSize)
+    {
+        auto last = prev(m_heights.end());
+        LOGGER(error) << "FinalityTracker full - dropping tx " << toHex(last->second) << " at height " << last->first << "." << endl;
+        m_txs.erase(last->second);
+        m_heights.erase(last);
+        m_evicted++;
+    }
+}
+
+void FinalityTracker::untrack(const bytes_t& unsignedHash)
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_txs.find(unsignedHash);
+    if (it == m_txs.end()) return;
+
+    m_heights.erase(height_key_t(it->second.height, unsignedHash));
+    m_txs.erase(it);
+}
+
+vector<shared_ptr<Tx>> FinalityTracker::sweep(uint32_t finalHeight)
+{
+    vector<shared_ptr<Tx>> txs;
+
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_heights.begin();
+    for (; it != m_heights.end() && it->first <= finalHeight; ++it)
+    {
+        auto txIt = m_txs.find(it->second);
+        txs.push_back(txIt->second.tx);
+        m_txs.erase(txIt);
+    }
+    m_heights.erase(m_heights.begin(), it);
+    m_finalized += txs.size();
+    return txs;
+}
+
+Object FinalityTracker::getMetricsObject()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Object result;
+    result.push_back(Pair("pending", (uint64_t)m_txs.size()));
+    result.push_back(Pair("lowestheight", m_heights.empty() ? (uint64_t)0 : (uint64_t)m_heights.begin()->first));
+    result.push_back(Pair("finalized", m_finalized));
+    result.push_back(Pair("requeued", m_requeued));
+    result.push_back(Pair("evicted", m_evicted));
+    return result;
+}
+
+FinalityTracker& CoinSocket::getFinalityTracker()
+{
+    static FinalityTracker finalityTracker;
+    return finalityTracker;
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// finality.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <CoinDB/Schema.h>
+
+#include <json_spirit/json_spirit_value.h>
+
+#include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Confirmed txs waiting for enough confirmations to be final, ordered by
+// height. Sweeping takes out everything at or below the final height, so no
+// tx is missed when the sync height jumps several blocks at once.
+class FinalityTracker
+{
+public:
+    FinalityTracker() : m_maxSize(0), m_finalized(0), m_requeued(0), m_evicted(0) { }
+
+    // Beyond this many txs the ones furthest from final are dropped.
+    void setMaxSize(size_t maxSize);
+
+    // Tracking a tx again at a different height, as after a reorg, moves it.
+    void track(const std::shared_ptr<CoinDB::Tx>& tx, uint32_t height);
+    void untrack(const bytes_t& unsignedHash);
+
+    // Removes and returns the txs at or below finalHeight, lowest first.
+    std::vector<std::shared_ptr<CoinDB::Tx>> sweep(uint32_t finalHeight);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    typedef std::pair<uint32_t, bytes_t> height_key_t;
+
+    struct Entry
+    {
+        uint32_t height;
+        std::shared_ptr<CoinDB::Tx> tx;
+    };
+
+    std::mutex m_mutex;
+    size_t m_maxSize;
+    std::map<bytes_t, Entry> m_txs;
+    std::set<height_key_t> m_heights;
+    uint64_t m_finalized;
+    uint64_t m_requeued;
+    uint64_t m_evicted;
+};
+
+FinalityTracker& getFinalityTracker();
+
+}
@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// hex.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "hex.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace CoinSocket;
+using namespace std;
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void encodeScalar(char* out, const unsigned char* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        *out++ = HEX_DIGITS[data[i] >> 4];
+        *out++ = HEX_DIGITS[data[i] & 0x0f];
+    }
+}
+
+static bool decodeScalar(unsigned char* out, const char* hex, size_t size)
+{
+    for (size_t i = 0; i < size; i += 2)
+    {
+        int hi = hexValue(hex[i]);
+        int lo = hexValue(hex[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        *out++ = (unsigned char)((hi << 4) | lo);
+    }
+    return true;
+}
+
+#if defined(__AVX2__)
+
+// Nibbles to ascii: '0' + n, plus the gap up to 'a' for n > 9.
+static inline __m256i nibblesToHex(__m256i nibbles)
+{
+    __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+    return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), letters);
+}
+
+// Returns the nibble values, or sets bValid to false.
+static inline __m256i hexToNibbles(__m256i chars, bool& bValid)
+{
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    __m256i isAlpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) != -1) { bValid = false; }
+
+    __m256i digits = _mm256_and_si256(isDigit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0')));
+    __m256i alphas = _mm256_and_si256(isAlpha, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)));
+    return _mm256_or_si256(digits, alphas);
+}
+
+static size_t encodeVector(char* out, const unsigned char* data, size_t size)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i hi = nibblesToHex(_mm256_and_si256(_mm256_srli_epi16(bytes, 4), mask));
+        __m256i lo = nibblesToHex(_mm256_and_si256(bytes, mask));
+
+        // Interleaving works within each 128-bit lane, so put the lanes back in order.
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i*)(out + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return i;
+}
+
+static size_t decodeVector(unsigned char* out, const char* hex, size_t size, bool& bValid)
+{
+    const __m256i lowByte = _mm256_set1_epi16(0x00ff);
+    size_t i = 0;
+    for (; i + 64 <= size && bValid; i += 64)
+    {
+        __m256i a = hexToNibbles(_mm256_loadu_si256((const __m256i*)(hex + i)), bValid);
+        __m256i b = hexToNibbles(_mm256_loadu_si256((const __m256i*)(hex + i + 32)), bValid);
+
+        // Each 16-bit lane holds a high nibble in its low byte and a low nibble in its high byte.
+        a = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(a, lowByte), 4), _mm256_srli_epi16(a, 8));
+        b = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(b, lowByte), 4), _mm256_srli_epi16(b, 8));
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+        _mm256_storeu_si256((__m256i*)(out + i / 2), packed);
+    }
+    return bValid ? i : 0;
+}
+
+#elif defined(__SSE2__)
+
+static inline __m128i nibblesToHex(__m128i nibbles)
+{
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+static inline __m128i hexToNibbles(__m128i chars, bool& bValid)
+{
+    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xffff) { bValid = false; }
+
+    __m128i digits = _mm_and_si128(isDigit, _mm_sub_epi8(chars, _mm_set1_epi8('0')));
+    __m128i alphas = _mm_and_si128(isAlpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)));
+    return _mm_or_si128(digits, alphas);
+}
+
+static size_t encodeVector(char* out, const unsigned char* data, size_t size)
+{
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i hi = nibblesToHex(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+        __m128i lo = nibblesToHex(_mm_and_si128(bytes, mask));
+        _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+static size_t decodeVector(unsigned char* out, const char* hex, size_t size, bool& bValid)
+{
+    const __m128i lowByte = _mm_set1_epi16(0x00ff);
+    size_t i = 0;
+    for (; i + 32 <= size && bValid; i += 32)
+    {
+        __m128i a = hexToNibbles(_mm_loadu_si128((const __m128i*)(hex + i)), bValid);
+        __m128i b = hexToNibbles(_mm_loadu_si128((const __m128i*)(hex + i + 16)), bValid);
+
+        // Each 16-bit lane holds a high nibble in its low byte and a low nibble in its high byte.
+        a = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, lowByte), 4), _mm_srli_epi16(a, 8));
+        b = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, lowByte), 4), _mm_srli_epi16(b, 8));
+        _mm_storeu_si128((__m128i*)(out + i / 2), _mm_packus_epi16(a, b));
+    }
+    return bValid ? i : 0;
+}
+
+#else
+
+static size_t encodeVector(char* /*out*/, const unsigned char* /*data*/, size_t /*size*/) { return 0; }
+static size_t decodeVector(unsigned char* /*out*/, const char* /*hex*/, size_t /*size*/, bool& /*bValid*/) { return 0; }
+
+#endif
+
+void CoinSocket::appendHex(string& out, const unsigned char* data, size_t size)
+{
+    size_t pos = out.size();
+    out.resize(pos + 2 * size);
+    char* dest = &out[pos];
+
+    size_t done = encodeVector(dest, data, size);
+    encodeScalar(dest + 2 * done, data + done, size - done);
+}
+
+string CoinSocket::toHex(const bytes_t& bytes)
+{
+    string hex;
+    appendHex(hex, bytes.data(), bytes.size());
+    return hex;
+}
+
+bool CoinSocket::hexToBytes(const string& hex, bytes_t& bytes)
+{
+    const char* src = hex.data();
+    size_t size = hex.size();
+
+    bytes.resize((size + 1) / 2);
+    unsigned char* dest = bytes.data();
+
+    if (size % 2)
+    {
+        int lo = hexValue(*src);
+        if (lo < 0) return false;
+        *dest++ = (unsigned char)lo;
+        src++;
+        size--;
+    }
+
+    bool bValid = true;
+    size_t done = decodeVector(dest, src, size, bValid);
+    if (!bValid) return false;
+
+    return decodeScalar(dest + done / 2, src + done, size - done);
+}
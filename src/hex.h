@@ -0,0 +1,34 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// hex.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <stdutils/uchar_vector.h>
+
+#include <string>
+
+namespace CoinSocket
+{
+
+// Hex conversion for hashes, scripts and raw txs. Uses AVX2 when built with
+// ENABLE_AVX2, otherwise SSE2 where available, with a scalar fallback for
+// other targets and for the tail of each buffer.
+
+// Lowercase, as uchar_vector::getHex gives.
+void appendHex(std::string& out, const unsigned char* data, size_t size);
+std::string toHex(const bytes_t& bytes);
+
+// Accepts either case. An odd number of digits is read as if padded with a
+// leading zero, as uchar_vector does. Returns false on any other character.
+bool hexToBytes(const std::string& hex, bytes_t& bytes);
+
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// idempotency.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "idempotency.h"
+#include "CoinSocketExceptions.h"
+
+#include <CoinCore/hash.h>
+
+#include <json_spirit/json_spirit_writer_template.h>
+
+using namespace CoinSocket;
+using namespace json_spirit;
+using namespace std;
+
+static IdempotencyCache g_idempotencyCache;
+
+IdempotencyCache& CoinSocket::getIdempotencyCache()
+{
+    return g_idempotencyCache;
+}
+
+void IdempotencyCache::setMaxSize(size_t maxSize)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_maxSize = maxSize;
+    while (m_entries.size() > m_maxSize)
+    {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+bool IdempotencyCache::get(const string& key, const string& method, const Array& params, Value& result)
+{
+    bytes_t requestDigest = getRequestDigest(method, params);
+
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+    {
+        m_misses++;
+        return false;
+    }
+
+    if (it->second->requestDigest != requestDigest) throw CommandIdempotencyKeyReusedException();
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    result = it->second->result;
+    m_hits++;
+    return true;
+}
+
+void IdempotencyCache::put(const string& key, const string& method, const Array& params, const Value& result)
+{
+    Entry entry;
+    entry.key = key;
+    entry.requestDigest = getRequestDigest(method, params);
+    entry.result = result;
+
+    lock_guard<mutex> lock(m_mutex);
+    if (m_maxSize == 0 || m_index.count(entry.key)) return;
+
+    m_entries.push_front(entry);
+    m_index[entry.key] = m_entries.begin();
+
+    if (m_entries.size() > m_maxSize)
+    {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+Object IdempotencyCache::getMetricsObject()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Object result;
+    result.push_back(Pair("size", (uint64_t)m_entries.size()));
+    result.push_back(Pair("hits", m_hits));
+    result.push_back(Pair("misses", m_misses));
+    return result;
+}
+
+bytes_t IdempotencyCache::getRequestDigest(const string& method, const Array& params)
+{
+    string request = method + write_string<Value>(params);
+    return sha256(bytes_t(request.begin(), request.end()));
+}
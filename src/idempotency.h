@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// idempotency.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <json_spirit/json_spirit_value.h>
+#include <stdutils/uchar_vector.h>
+
+#include <string>
+#include <list>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Results of recent mutating commands keyed by a client-supplied
+// idempotency key. Keys are global rather than per connection, since a
+// client retrying after a reconnect has to find its earlier result. Clients
+// should use keys that are unique to them, such as UUIDs. Only a digest of
+// each request is kept, so params such as keychain secrets are not held in
+// memory. The least recently used entries are evicted once the cache is full.
+class IdempotencyCache
+{
+public:
+    IdempotencyCache() : m_maxSize(0), m_hits(0), m_misses(0) { }
+
+    void setMaxSize(size_t maxSize);
+
+    // Returns true and sets result if the key is cached. Throws if the key
+    // was used for a different request.
+    bool get(const std::string& key, const std::string& method, const json_spirit::Array& params, json_spirit::Value& result);
+    void put(const std::string& key, const std::string& method, const json_spirit::Array& params, const json_spirit::Value& result);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    struct Entry
+    {
+        std::string key;
+        bytes_t requestDigest;
+        json_spirit::Value result;
+    };
+
+    typedef std::list<Entry> entry_list_t;
+
+    std::mutex m_mutex;
+    size_t m_maxSize;
+    entry_list_t m_entries;
+    std::map<std::string, entry_list_t::iterator> m_index;
+    uint64_t m_hits;
+    uint64_t m_misses;
+
+    static bytes_t getRequestDigest(const std::string& method, const json_spirit::Array& params);
+};
+
+IdempotencyCache& getIdempotencyCache();
+
+}
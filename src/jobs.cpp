@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// jobs.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "jobs.h"
+#include "outbound.h"
+
+#include <json_spirit/json_spirit_writer_template.h>
+
+#include <atomic>
+#include <sstream>
+
+using namespace CoinSocket;
+using namespace WebSocket;
+using namespace json_spirit;
+using namespace std;
+
+// Progress events are throttled so a tight loop cannot flood the client.
+const chrono::milliseconds JOB_PROGRESS_INTERVAL(250);
+
+static atomic<uint64_t> g_lastJobId(0);
+static thread_local JobScope* g_currentJob = nullptr;
+
+uint64_t CoinSocket::newJobId()
+{
+    return ++g_lastJobId;
+}
+
+JobScope::JobScope(Server& server, websocketpp::connection_hdl hdl, uint64_t jobId, const string& method)
+    : m_server(server), m_hdl(hdl), m_jobId(jobId), m_method(method), m_parent(g_currentJob)
+{
+    g_currentJob = this;
+    m_lastProgress = chrono::steady_clock::now();
+    sendEvent("jobstarted", getJobObject());
+}
+
+JobScope::~JobScope()
+{
+    g_currentJob = m_parent;
+}
+
+void JobScope::progress(uint64_t done, uint64_t total)
+{
+    auto now = chrono::steady_clock::now();
+    if (done < total && now - m_lastProgress < JOB_PROGRESS_INTERVAL) return;
+    m_lastProgress = now;
+
+    Object data = getJobObject();
+    data.push_back(Pair("done", done));
+    data.push_back(Pair("total", total));
+    sendEvent("jobprogress", data, true);
+}
+
+void JobScope::complete(const Value& result)
+{
+    Object data = getJobObject();
+    data.push_back(Pair("result", result));
+    data.push_back(Pair("error", Value()));
+    sendEvent("jobcompleted", data);
+}
+
+void JobScope::fail(const Object& error)
+{
+    Object data = getJobObject();
+    data.push_back(Pair("result", Value()));
+    data.push_back(Pair("error", error));
+    sendEvent("jobcompleted", data);
+}
+
+Object JobScope::getJobObject() const
+{
+    Object data;
+    data.push_back(Pair("jobid", m_jobId));
+    data.push_back(Pair("method", m_method));
+    return data;
+}
+
+void JobScope::sendEvent(const string& event, const Object& data, bool bDroppable)
+{
+    stringstream msg;
+    msg << "{\"event\":\"" << event << "\", \"data\":" << write_string<Value>(data) << "}";
+
+    // Only the latest progress event for a job matters, so it may be coalesced.
+    if (bDroppable) { getOutbound().sendEvent(m_hdl, msg.str(), event + ":" + to_string(m_jobId)); }
+    else            { getOutbound().send(m_hdl, msg.str()); }
+}
+
+void CoinSocket::reportJobProgress(uint64_t done, uint64_t total)
+{
+    if (g_currentJob) { g_currentJob->progress(done, total); }
+}
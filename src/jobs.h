@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// jobs.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <json_spirit/json_spirit_value.h>
+#include <WebSocketAPI/Server.h>
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+uint64_t newJobId();
+
+// Marks the calling thread as running a job for the lifetime of the scope.
+// Events for the job are sent to the connection that submitted it.
+class JobScope
+{
+public:
+    JobScope(WebSocket::Server& server, websocketpp::connection_hdl hdl, uint64_t jobId, const std::string& method);
+    ~JobScope();
+
+    void progress(uint64_t done, uint64_t total);
+    void complete(const json_spirit::Value& result);
+    void fail(const json_spirit::Object& error);
+
+private:
+    WebSocket::Server& m_server;
+    websocketpp::connection_hdl m_hdl;
+    uint64_t m_jobId;
+    std::string m_method;
+    JobScope* m_parent;
+    std::chrono::steady_clock::time_point m_lastProgress;
+
+    json_spirit::Object getJobObject() const;
+    void sendEvent(const std::string& event, const json_spirit::Object& data, bool bDroppable = false);
+};
+
+// Called by command handlers at convenient points. Does nothing unless the
+// command is running as a job.
+void reportJobProgress(uint64_t done, uint64_t total);
+
+}
@@ -11,10 +11,10 @@
 //
 
 #include "jsonobjects.h"
-#include "coinparams.h"
+#include "hex.h"
+#include "addresscache.h"
 #include "txproposal.h"
 
-#include <CoinQ/CoinQ_script.h>
 #include <CoinDB/Schema.h>
 #include <CoinDB/SigningRequest.h>
 #include <CoinDB/SynchedVault.h>
@@ -29,20 +29,20 @@ Object CoinSocket::getSyncStatusObject(const SynchedVault& synchedVault)
     Object result;
     result.push_back(Pair("status", SynchedVault::getStatusString(synchedVault.getStatus())));
     result.push_back(Pair("syncheight", (uint64_t)synchedVault.getSyncHeight()));
-    result.push_back(Pair("synchash", uchar_vector(synchedVault.getSyncHash()).getHex()));
+    result.push_back(Pair("synchash", toHex(synchedVault.getSyncHash())));
     result.push_back(Pair("bestheight", (uint64_t)synchedVault.getBestHeight()));
-    result.push_back(Pair("besthash", uchar_vector(synchedVault.getBestHash()).getHex()));
+    result.push_back(Pair("besthash", toHex(synchedVault.getBestHash())));
     return result;
 }
 
 Object CoinSocket::getBlockHeaderObject(const BlockHeader& header)
 {
     Object result;
-    result.push_back(Pair("hash", uchar_vector(header.hash()).getHex()));
+    result.push_back(Pair("hash", toHex(header.hash())));
     result.push_back(Pair("height", (uint64_t)header.height()));
     result.push_back(Pair("version", (uint64_t)header.version()));
-    result.push_back(Pair("prevhash", uchar_vector(header.prevhash()).getHex()));
-    result.push_back(Pair("merkleroot", uchar_vector(header.merkleroot()).getHex()));
+    result.push_back(Pair("prevhash", toHex(header.prevhash())));
+    result.push_back(Pair("merkleroot", toHex(header.merkleroot())));
     result.push_back(Pair("timestamp", (uint64_t)header.timestamp()));
     result.push_back(Pair("bits", (uint64_t)header.bits()));
     result.push_back(Pair("nonce", (uint64_t)header.nonce()));
@@ -57,8 +57,8 @@ Object CoinSocket::getKeychainObject(const Keychain& keychain)
     result.push_back(Pair("depth", (int)keychain.depth()));
     result.push_back(Pair("parentfp", (uint64_t)keychain.parent_fp()));
     result.push_back(Pair("childnum", (uint64_t)keychain.child_num()));
-    result.push_back(Pair("pubkey", uchar_vector(keychain.pubkey()).getHex()));
-    result.push_back(Pair("hash", uchar_vector(keychain.hash()).getHex()));
+    result.push_back(Pair("pubkey", toHex(keychain.pubkey())));
+    result.push_back(Pair("hash", toHex(keychain.hash())));
     return result;
 }
 
@@ -73,7 +73,7 @@ Object CoinSocket::getUserObject(const CoinDB::User& user)
     std::vector<std::string> addresses;
     for (auto& script: scripts)
     {
-        addresses.push_back(CoinQ::Script::getAddressForTxOutScript(script, getCoinParams().address_versions()));
+        addresses.push_back(getAddressCache().getAddress(script));
     }
     result.push_back(Pair("addresses", Array(addresses.begin(), addresses.end())));
     return result;
@@ -99,7 +99,7 @@ Object CoinSocket::getTxViewObject(const TxView& txview)
 
     Object result;
     result.push_back(Pair("id", (uint64_t)txview.id));
-    result.push_back(Pair("hash", uchar_vector(hash).getHex()));
+    result.push_back(Pair("hash", toHex(hash)));
     result.push_back(Pair("status", CoinDB::Tx::getStatusString(txview.status, true)));
     result.push_back(Pair("version", (uint64_t)txview.version));
     result.push_back(Pair("locktime", (uint64_t)txview.locktime));
@@ -115,10 +115,10 @@ Object CoinSocket::getSigningRequestObject(const SigningRequest& req)
     for (auto& keychain_pair: req.keychain_info())
     {
         keychain_names.push_back(keychain_pair.first);
-        keychain_hashes.push_back(uchar_vector(keychain_pair.second).getHex());
+        keychain_hashes.push_back(toHex(keychain_pair.second));
     }
-    std::string hash = uchar_vector(req.hash()).getHex();
-    std::string rawtx = uchar_vector(req.rawtx()).getHex();
+    std::string hash = toHex(req.hash());
+    std::string rawtx = toHex(req.rawtx());
 
     Object result;
     result.push_back(Pair("hash", hash));
@@ -151,7 +151,7 @@ Object CoinSocket::getTxProposalObject(const CoinSocket::TxProposal& txProposal)
     }
 
     Object result;
-    result.push_back(Pair("proposalid", uchar_vector(txProposal.hash()).getHex()));
+    result.push_back(Pair("proposalid", toHex(txProposal.hash())));
     result.push_back(Pair("status", statusString));
     result.push_back(Pair("username", txProposal.username()));
     result.push_back(Pair("account", txProposal.account()));
@@ -168,9 +168,9 @@ Object CoinSocket::getTxProposalObject(const CoinSocket::TxProposal& txProposal)
 Object CoinSocket::getTxInObject(const CoinDB::TxIn& txin)
 {
     Object result;
-    result.push_back(Pair("outhash", uchar_vector(txin.outhash()).getHex()));
+    result.push_back(Pair("outhash", toHex(txin.outhash())));
     result.push_back(Pair("outindex", (uint64_t)txin.outindex()));
-    result.push_back(Pair("script", uchar_vector(txin.script()).getHex()));
+    result.push_back(Pair("script", toHex(txin.script())));
     result.push_back(Pair("sequence", (uint64_t)txin.sequence()));
     return result;
 }
@@ -178,11 +178,11 @@ Object CoinSocket::getTxInObject(const CoinDB::TxIn& txin)
 Object CoinSocket::getTxOutObject(const CoinDB::TxOut& txout)
 {
     Object result;
-    result.push_back(Pair("address", CoinQ::Script::getAddressForTxOutScript(txout.script(), getCoinParams().address_versions())));
+    result.push_back(Pair("address", getAddressCache().getAddress(txout.script())));
     result.push_back(Pair("value", (uint64_t)txout.value()));
     result.push_back(Pair("sending_label", txout.sending_label()));
     result.push_back(Pair("receiving_label", txout.receiving_label()));
-    result.push_back(Pair("script", uchar_vector(txout.script()).getHex()));
+    result.push_back(Pair("script", toHex(txout.script())));
     return result;
 }
 
@@ -191,8 +191,8 @@ Object CoinSocket::getTxObject(const CoinDB::Tx& tx, bool includeRawHex, bool in
     Object result;
     result.push_back(Pair("version", (uint64_t)tx.version()));
     result.push_back(Pair("locktime", (uint64_t)tx.locktime()));
-    result.push_back(Pair("hash", uchar_vector(tx.hash()).getHex()));
-    result.push_back(Pair("unsignedhash", uchar_vector(tx.unsigned_hash()).getHex()));
+    result.push_back(Pair("hash", toHex(tx.hash())));
+    result.push_back(Pair("unsignedhash", toHex(tx.unsigned_hash())));
     result.push_back(Pair("status", CoinDB::Tx::getStatusString(tx.status())));
     if (tx.blockheader())   { result.push_back(Pair("height", (uint64_t)tx.blockheader()->height())); }
     else                    { result.push_back(Pair("height", Value())); /* null */ }
@@ -205,8 +205,58 @@ Object CoinSocket::getTxObject(const CoinDB::Tx& tx, bool includeRawHex, bool in
     for (auto& txout: tx.txouts())  { txoutObjs.push_back(getTxOutObject(*txout)); }
     result.push_back(Pair("txouts", Array(txoutObjs.begin(), txoutObjs.end())));
 
-    if (includeRawHex)      { result.push_back(Pair("rawtx", uchar_vector(tx.raw()).getHex())); }
+    if (includeRawHex)      { result.push_back(Pair("rawtx", toHex(tx.raw()))); }
     if (includeSerialized)  { result.push_back(Pair("serializedtx", tx.toSerialized())); }
 
     return result;
-} 
+}
+
+void CoinSocket::writeTxInJson(JsonWriter& writer, const CoinDB::TxIn& txin)
+{
+    writer.beginObject();
+    writer.key("outhash").hex(txin.outhash());
+    writer.key("outindex").value((uint64_t)txin.outindex());
+    writer.key("script").hex(txin.script());
+    writer.key("sequence").value((uint64_t)txin.sequence());
+    writer.endObject();
+}
+
+void CoinSocket::writeTxOutJson(JsonWriter& writer, const CoinDB::TxOut& txout)
+{
+    writer.beginObject();
+    writer.key("address").value(getAddressCache().getAddress(txout.script()));
+    writer.key("value").value((uint64_t)txout.value());
+    writer.key("sending_label").value(txout.sending_label());
+    writer.key("receiving_label").value(txout.receiving_label());
+    writer.key("script").hex(txout.script());
+    writer.endObject();
+}
+
+void CoinSocket::writeTxJson(JsonWriter& writer, const CoinDB::Tx& tx, bool includeRawHex, bool includeSerialized)
+{
+    writer.beginObject();
+    writeTxMembers(writer, tx, includeRawHex, includeSerialized);
+    writer.endObject();
+}
+
+void CoinSocket::writeTxMembers(JsonWriter& writer, const CoinDB::Tx& tx, bool includeRawHex, bool includeSerialized)
+{
+    writer.key("version").value((uint64_t)tx.version());
+    writer.key("locktime").value((uint64_t)tx.locktime());
+    writer.key("hash").hex(tx.hash());
+    writer.key("unsignedhash").hex(tx.unsigned_hash());
+    writer.key("status").value(CoinDB::Tx::getStatusString(tx.status()));
+    if (tx.blockheader())   { writer.key("height").value((uint64_t)tx.blockheader()->height()); }
+    else                    { writer.key("height").null(); }
+
+    writer.key("txins").beginArray();
+    for (auto& txin: tx.txins())    { writeTxInJson(writer, *txin); }
+    writer.endArray();
+
+    writer.key("txouts").beginArray();
+    for (auto& txout: tx.txouts())  { writeTxOutJson(writer, *txout); }
+    writer.endArray();
+
+    if (includeRawHex)      { writer.key("rawtx").hex(tx.raw()); }
+    if (includeSerialized)  { writer.key("serializedtx").value(tx.toSerialized()); }
+}
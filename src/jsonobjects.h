@@ -16,6 +16,8 @@
 #include <json_spirit/json_spirit_writer_template.h>
 #include <json_spirit/json_spirit_utils.h>
 
+#include "jsonwriter.h"
+
 namespace CoinDB
 {
     class TxIn;
@@ -47,4 +49,13 @@ json_spirit::Object getTxInObject(const CoinDB::TxIn& txin);
 json_spirit::Object getTxOutObject(const CoinDB::TxOut& txout);
 json_spirit::Object getTxObject(const CoinDB::Tx& tx, bool includeRaw = false, bool includeSerialized = false);
 
+// The same JSON as the builders above, written without building a tree.
+void writeTxInJson(JsonWriter& writer, const CoinDB::TxIn& txin);
+void writeTxOutJson(JsonWriter& writer, const CoinDB::TxOut& txout);
+void writeTxJson(JsonWriter& writer, const CoinDB::Tx& tx, bool includeRaw = false, bool includeSerialized = false);
+
+// Writes the members of a tx into an object the caller has begun, so more
+// can be added before it is closed.
+void writeTxMembers(JsonWriter& writer, const CoinDB::Tx& tx, bool includeRaw = false, bool includeSerialized = false);
+
 }
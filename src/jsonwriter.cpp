@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// jsonwriter.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "jsonwriter.h"
+#include "hex.h"
+
+#include <cstring>
+
+using namespace CoinSocket;
+using namespace std;
+
+// Uppercase, as json_spirit writes its \u escapes.
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+JsonWriter& JsonWriter::beginObject()
+{
+    separate();
+    m_buffer += '{';
+    m_first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    m_buffer += '}';
+    m_first.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    separate();
+    m_buffer += '[';
+    m_first.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    m_buffer += ']';
+    m_first.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name)
+{
+    separate();
+    appendString(name, strlen(name));
+    m_buffer += ':';
+
+    // The value that follows needs no comma of its own.
+    if (!m_first.empty()) { m_first.back() = true; }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const string& str)
+{
+    separate();
+    appendString(str.data(), str.size());
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* str)
+{
+    separate();
+    appendString(str, strlen(str));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(uint64_t n)
+{
+    separate();
+
+    char digits[20];
+    int i = 0;
+    do
+    {
+        digits[i++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+
+    while (i) { m_buffer += digits[--i]; }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool b)
+{
+    separate();
+    m_buffer += b ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+    separate();
+    m_buffer += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::hex(const bytes_t& bytes)
+{
+    separate();
+    m_buffer += '"';
+    appendHex(m_buffer, bytes.data(), bytes.size());
+    m_buffer += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::json(const string& json)
+{
+    separate();
+    m_buffer += json;
+    return *this;
+}
+
+JsonWriter& JsonWriter::members(const string& json)
+{
+    if (json.empty()) return *this;
+
+    separate();
+    m_buffer += json;
+    return *this;
+}
+
+void JsonWriter::separate()
+{
+    if (m_first.empty()) return;
+
+    if (m_first.back())     { m_first.back() = false; }
+    else                    { m_buffer += ','; }
+}
+
+void JsonWriter::appendString(const char* str, size_t size)
+{
+    m_buffer += '"';
+    for (size_t i = 0; i < size; i++)
+    {
+        unsigned char c = str[i];
+        switch (c)
+        {
+        case '"':   m_buffer += "\\\""; break;
+        case '\\':  m_buffer += "\\\\"; break;
+        case '\b':  m_buffer += "\\b"; break;
+        case '\f':  m_buffer += "\\f"; break;
+        case '\n':  m_buffer += "\\n"; break;
+        case '\r':  m_buffer += "\\r"; break;
+        case '\t':  m_buffer += "\\t"; break;
+        default:
+            // json_spirit only leaves printable characters as they are, and
+            // in the C locale that is printable ASCII. Every other byte,
+            // including each byte of a UTF-8 sequence, becomes \u00XX.
+            if (c < 0x20 || c > 0x7e)
+            {
+                m_buffer += "\\u00";
+                m_buffer += HEX_DIGITS[c >> 4];
+                m_buffer += HEX_DIGITS[c & 0x0f];
+            }
+            else
+            {
+                m_buffer += (char)c;
+            }
+        }
+    }
+    m_buffer += '"';
+}
@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// jsonwriter.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <stdutils/uchar_vector.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Appends compact JSON text straight into a buffer, for hot paths that would
+// otherwise build a json_spirit tree only to walk it again in write_string.
+// Commas are inserted automatically and strings are escaped as write_string
+// escapes them, so the text is byte for byte what json_spirit would give. The
+// buffer keeps its capacity across clear() so a writer can be reused.
+class JsonWriter
+{
+public:
+    JsonWriter() { }
+
+    void clear() { m_buffer.clear(); m_first.clear(); }
+    const std::string& str() const { return m_buffer; }
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(const char* name);
+
+    JsonWriter& value(const std::string& str);
+    JsonWriter& value(const char* str);
+    JsonWriter& value(uint64_t n);
+    JsonWriter& value(bool b);
+    JsonWriter& null();
+
+    // Lowercase hex, as uchar_vector::getHex gives.
+    JsonWriter& hex(const bytes_t& bytes);
+
+    // Already valid JSON text.
+    JsonWriter& json(const std::string& json);
+
+    // Already valid members of the open object, without the braces.
+    JsonWriter& members(const std::string& json);
+
+private:
+    std::string m_buffer;
+    std::vector<bool> m_first;
+
+    void separate();
+    void appendString(const char* str, size_t size);
+};
+
+}
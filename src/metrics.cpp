@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// metrics.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "metrics.h"
+#include "commands.h"
+
+#include "CoinSocketExceptions.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+using namespace CoinSocket;
+using namespace json_spirit;
+using namespace std;
+
+// LatencyHistogram
+LatencyHistogram::LatencyHistogram()
+    : m_count(0), m_sum(0), m_max(0)
+{
+    for (auto& bucket: m_buckets) { bucket.store(0, memory_order_relaxed); }
+}
+
+unsigned int LatencyHistogram::getBucket(uint64_t value)
+{
+    if (value < SUB_BUCKETS) return (unsigned int)value;
+
+    unsigned int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT) return BUCKET_COUNT - 1;
+
+    unsigned int subBucket = (unsigned int)(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + subBucket;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(unsigned int bucket)
+{
+    if (bucket < SUB_BUCKETS) return bucket;
+
+    unsigned int exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t subBucket = bucket % SUB_BUCKETS;
+    uint64_t lowerBound = (SUB_BUCKETS + subBucket) << (exponent - SUB_BUCKET_BITS);
+    return lowerBound + ((uint64_t)1 << (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    m_buckets[getBucket(value)].fetch_add(1, memory_order_relaxed);
+    m_count.fetch_add(1, memory_order_relaxed);
+    m_sum.fetch_add(value, memory_order_relaxed);
+
+    uint64_t max = m_max.load(memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, memory_order_relaxed)) { }
+}
+
+uint64_t LatencyHistogram::mean() const
+{
+    uint64_t n = count();
+    return n ? m_sum.load(memory_order_relaxed) / n : 0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < BUCKET_COUNT; i++)
+    {
+        counts[i] = m_buckets[i].load(memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) return 0;
+
+    uint64_t target = (uint64_t)(p * total);
+    if (target < 1) { target = 1; }
+
+    uint64_t cumulative = 0;
+    for (unsigned int i = 0; i < BUCKET_COUNT; i++)
+    {
+        cumulative += counts[i];
+        if (cumulative >= target)
+        {
+            // Never report more than the largest recorded value.
+            uint64_t upperBound = getBucketUpperBound(i);
+            uint64_t maxValue = max();
+            return upperBound < maxValue ? upperBound : maxValue;
+        }
+    }
+    return max();
+}
+
+// Command metrics
+namespace
+{
+
+struct CommandStats
+{
+    CommandStats() : errors(0) { }
+
+    LatencyHistogram latency;
+    atomic<uint64_t> errors;
+};
+
+enum ErrorClass
+{
+    COMMAND_ERROR,
+    OPERATION_ERROR,
+    DATA_FORMAT_ERROR,
+    INTERNAL_ERROR,
+    CONFIG_ERROR,
+    OTHER_CUSTOM_ERROR,
+    OTHER_ERROR,
+    ERROR_CLASS_COUNT
+};
+
+const char* ERROR_CLASS_NAMES[ERROR_CLASS_COUNT] =
+{
+    "CommandException",
+    "OperationException",
+    "DataFormatException",
+    "InternalException",
+    "ConfigException",
+    "custom_error",
+    "exception"
+};
+
+atomic<uint64_t> g_errorCounts[ERROR_CLASS_COUNT];
+
+// Each concrete error is told apart by the code getErrorObject reports.
+mutex g_errorCodeMutex;
+map<int, uint64_t> g_errorCodeCounts;
+
+CommandStats* getCommandStats()
+{
+    static CommandStats* stats = new CommandStats[getCommandCount()];
+    return stats;
+}
+
+ErrorClass getErrorClass(const exception& e)
+{
+    if (dynamic_cast<const CommandException*>(&e))      return COMMAND_ERROR;
+    if (dynamic_cast<const OperationException*>(&e))    return OPERATION_ERROR;
+    if (dynamic_cast<const DataFormatException*>(&e))   return DATA_FORMAT_ERROR;
+    if (dynamic_cast<const InternalException*>(&e))     return INTERNAL_ERROR;
+    if (dynamic_cast<const ConfigException*>(&e))       return CONFIG_ERROR;
+    if (dynamic_cast<const stdutils::custom_error*>(&e)) return OTHER_CUSTOM_ERROR;
+    return OTHER_ERROR;
+}
+
+}
+
+void CoinSocket::recordCommandLatency(const Command* command, uint64_t micros)
+{
+    if (!command) return;
+    getCommandStats()[command - getCommands()].latency.record(micros);
+}
+
+void CoinSocket::recordCommandError(const Command* command, const exception& e)
+{
+    g_errorCounts[getErrorClass(e)].fetch_add(1, memory_order_relaxed);
+
+    const stdutils::custom_error* ce = dynamic_cast<const stdutils::custom_error*>(&e);
+    if (ce && ce->has_code())
+    {
+        lock_guard<mutex> lock(g_errorCodeMutex);
+        g_errorCodeCounts[ce->code()]++;
+    }
+
+    if (!command) return;
+    getCommandStats()[command - getCommands()].errors.fetch_add(1, memory_order_relaxed);
+}
+
+Object CoinSocket::getMetricsObject()
+{
+    const Command* commands = getCommands();
+    CommandStats* stats = getCommandStats();
+
+    vector<Object> commandObjs;
+    for (size_t i = 0; i < getCommandCount(); i++)
+    {
+        const LatencyHistogram& latency = stats[i].latency;
+        uint64_t errors = stats[i].errors.load(memory_order_relaxed);
+        if (latency.count() == 0 && errors == 0) continue;
+
+        Object latencyObj;
+        latencyObj.push_back(Pair("p50", latency.percentile(0.5)));
+        latencyObj.push_back(Pair("p99", latency.percentile(0.99)));
+        latencyObj.push_back(Pair("p999", latency.percentile(0.999)));
+        latencyObj.push_back(Pair("mean", latency.mean()));
+        latencyObj.push_back(Pair("max", latency.max()));
+
+        Object commandObj;
+        commandObj.push_back(Pair("method", string(commands[i].name())));
+        commandObj.push_back(Pair("calls", latency.count()));
+        commandObj.push_back(Pair("errors", errors));
+        commandObj.push_back(Pair("latencyus", latencyObj));
+        commandObjs.push_back(commandObj);
+    }
+
+    Object errorObj;
+    for (unsigned int i = 0; i < ERROR_CLASS_COUNT; i++)
+    {
+        errorObj.push_back(Pair(ERROR_CLASS_NAMES[i], (uint64_t)g_errorCounts[i].load(memory_order_relaxed)));
+    }
+
+    Object errorCodeObj;
+    {
+        lock_guard<mutex> lock(g_errorCodeMutex);
+        for (auto& count: g_errorCodeCounts) { errorCodeObj.push_back(Pair(to_string(count.first), count.second)); }
+    }
+
+    Object result;
+    result.push_back(Pair("commands", Array(commandObjs.begin(), commandObjs.end())));
+    result.push_back(Pair("errors", errorObj));
+    result.push_back(Pair("errorcodes", errorCodeObj));
+    return result;
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// metrics.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <json_spirit/json_spirit_value.h>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+class Command;
+
+namespace CoinSocket
+{
+
+// Log-linear (HDR-style) latency histogram. Values below 16 get their own
+// bucket, larger values are split into 16 sub-buckets per power of two for
+// roughly 6% relative precision. All updates are lock-free.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(uint64_t value);
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t mean() const;
+    uint64_t percentile(double p) const;
+
+private:
+    static const unsigned int SUB_BUCKET_BITS = 4;
+    static const unsigned int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const unsigned int MAX_EXPONENT = 40;
+    static const unsigned int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    static unsigned int getBucket(uint64_t value);
+    static uint64_t getBucketUpperBound(unsigned int bucket);
+
+    std::atomic<uint64_t> m_buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
+
+// Command metrics - latencies are in microseconds.
+void recordCommandLatency(const Command* command, uint64_t micros);
+void recordCommandError(const Command* command, const std::exception& e);
+
+// Records the lifetime of the enclosing scope as one call of the command.
+class CommandTimer
+{
+public:
+    explicit CommandTimer(const Command* command) : m_command(command), m_start(std::chrono::steady_clock::now()) { }
+    ~CommandTimer()
+    {
+        recordCommandLatency(m_command, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+private:
+    const Command* m_command;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+json_spirit::Object getMetricsObject();
+
+}
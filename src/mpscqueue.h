@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// mpscqueue.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace CoinSocket
+{
+
+// Unbounded lock-free multi-producer single-consumer queue. Producers never
+// block each other beyond a single atomic exchange. Only one thread may pop.
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : m_head(new Node()), m_tail(m_head.load(std::memory_order_relaxed)) { }
+
+    ~MpscQueue()
+    {
+        T value;
+        while (pop(value));
+        delete m_tail;
+    }
+
+    void push(T value)
+    {
+        Node* node = new Node(std::move(value));
+        Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Returns false if the queue is empty or a push has not finished linking.
+    bool pop(T& value)
+    {
+        Node* next = m_tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        value = std::move(next->value);
+        delete m_tail;
+        m_tail = next;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        Node() : next(nullptr) { }
+        explicit Node(T value_) : value(std::move(value_)), next(nullptr) { }
+
+        T value;
+        std::atomic<Node*> next;
+    };
+
+    std::atomic<Node*> m_head;
+    Node* m_tail;
+
+    MpscQueue(const MpscQueue&);
+    MpscQueue& operator=(const MpscQueue&);
+};
+
+}
@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// outbound.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "outbound.h"
+#include "channels.h"
+#include "compression.h"
+#include "encoding.h"
+
+#include <logger/logger.h>
+
+#ifdef USE_TLS
+#include <websocketpp/config/asio.hpp>
+#else
+#include <websocketpp/config/asio_no_tls.hpp>
+#endif
+#include <websocketpp/server.hpp>
+
+#include <vector>
+#include <chrono>
+#include <type_traits>
+
+using namespace CoinSocket;
+using namespace WebSocket;
+using namespace json_spirit;
+using namespace std;
+
+// Maximum number of messages sent to one connection before moving on to the next.
+const size_t OUTBOUND_SEND_BATCH = 64;
+
+// How long a connection whose send buffer is full waits before it is tried again.
+const unsigned int OUTBOUND_THROTTLE_RETRY_MS = 10;
+
+// Must match the endpoint WebSocket::Server is built with, or the casts from
+// connection handles below are undefined.
+#ifdef USE_TLS
+typedef websocketpp::server<websocketpp::config::asio_tls> endpoint_t;
+#else
+typedef websocketpp::server<websocketpp::config::asio> endpoint_t;
+#endif
+static_assert(std::is_same<endpoint_t, Server::server_t>::value, "endpoint_t does not match WebSocket::Server");
+
+static const payload_ptr EVICTED_MESSAGE = make_shared<const string>("{\"event\":\"evicted\", \"data\":{\"reason\":\"outbound queue full\"}}");
+
+static Outbound g_outbound;
+
+Outbound& CoinSocket::getOutbound()
+{
+    return g_outbound;
+}
+
+// WebSocket::Server does not expose its connections, so they are reached
+// from the handle the way websocketpp's own endpoint does it.
+static endpoint_t::connection_ptr getConnection(websocketpp::connection_hdl hdl)
+{
+    return websocketpp::lib::static_pointer_cast<endpoint_t::connection_type>(hdl.lock());
+}
+
+// Bytes the library has accepted for the connection but not yet written.
+static size_t getBufferedAmount(websocketpp::connection_hdl hdl)
+{
+    endpoint_t::connection_ptr con = getConnection(hdl);
+    return con ? con->get_buffered_amount() : 0;
+}
+
+static void sendBinary(websocketpp::connection_hdl hdl, const string& payload)
+{
+    endpoint_t::connection_ptr con = getConnection(hdl);
+    if (!con) return;
+
+    websocketpp::lib::error_code ec = con->send(payload.data(), payload.size(), websocketpp::frame::opcode::binary);
+    if (ec) { LOGGER(error) << "Outbound send error: " << ec.message() << endl; }
+}
+
+static void closeConnection(websocketpp::connection_hdl hdl, const string& reason)
+{
+    endpoint_t::connection_ptr con = getConnection(hdl);
+    if (!con) return;
+
+    websocketpp::lib::error_code ec;
+    con->close(websocketpp::close::status::policy_violation, reason, ec);
+    if (ec) { LOGGER(error) << "Outbound close error: " << ec.message() << endl; }
+}
+
+bool CoinSocket::getOverflowPolicy(const string& name, OverflowPolicy& policy)
+{
+    if (name == "dropoldest")       { policy = DROP_OLDEST; return true; }
+    if (name == "coalesce")         { policy = COALESCE;    return true; }
+    if (name == "disconnect")       { policy = DISCONNECT;  return true; }
+    return false;
+}
+
+Outbound::Outbound()
+    : m_server(nullptr), m_maxMessages(0), m_maxBytes(0), m_policy(DROP_OLDEST), m_bRunning(false),
+      m_queuedMessages(0), m_queuedBytes(0), m_droppedMessages(0), m_coalescedMessages(0), m_evictions(0), m_throttledSends(0)
+{
+}
+
+void Outbound::start(Server& server, size_t maxMessages, size_t maxBytes, OverflowPolicy policy)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_bRunning) return;
+
+    m_server = &server;
+    m_maxMessages = maxMessages;
+    m_maxBytes = maxBytes;
+    m_policy = policy;
+    m_bRunning = true;
+    m_thread = thread(&Outbound::run, this);
+}
+
+void Outbound::stop()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_bRunning) return;
+        m_bRunning = false;
+    }
+
+    m_cond.notify_all();
+    m_thread.join();
+
+    lock_guard<mutex> lock(m_mutex);
+    m_queues.clear();
+    m_ready.clear();
+    m_throttled.clear();
+    m_queuedMessages = 0;
+    m_queuedBytes = 0;
+}
+
+void Outbound::send(websocketpp::connection_hdl hdl, string msg)
+{
+    send(hdl, make_shared<const string>(move(msg)));
+}
+
+void Outbound::send(websocketpp::connection_hdl hdl, const payload_ptr& payload, bool bBinary)
+{
+    Message message(payload, string(), false, bBinary);
+
+    lock_guard<mutex> lock(m_mutex);
+    enqueue(hdl, message);
+}
+
+void Outbound::sendEvent(websocketpp::connection_hdl hdl, string msg, const string& key)
+{
+    Message message(make_shared<const string>(move(msg)), key, true);
+
+    lock_guard<mutex> lock(m_mutex);
+    enqueue(hdl, message);
+}
+
+void Outbound::sendEvent(websocketpp::connection_hdl hdl, const payload_ptr& payload, const string& key, bool bBinary)
+{
+    Message message(payload, key, true, bBinary);
+
+    lock_guard<mutex> lock(m_mutex);
+    enqueue(hdl, message);
+}
+
+void Outbound::sendChannel(const string& channel, string msg, const string& key)
+{
+    sendChannel(channel, make_shared<const string>(move(msg)), key);
+}
+
+void Outbound::sendChannel(const string& channel, const payload_ptr& payload, const string& key, const TxAttributes* attributes, const payload_ptr& binaryPayload)
+{
+    Subscribers subscribers = getSubscribers(channel);
+    if (subscribers.empty()) return;
+
+    BinaryConnections binaryConnections;
+    if (binaryPayload) { binaryConnections = getBinaryConnections(); }
+
+    // Every subscriber's queue shares the one payload buffer.
+    Message message(payload, key.empty() ? key : channel + ":" + key, true);
+    Message binaryMessage(binaryPayload, message.key, true, true);
+
+    lock_guard<mutex> lock(m_mutex);
+    for (auto& subscriber: subscribers)
+    {
+        if (!filterMatches(subscriber.second, attributes)) continue;
+        enqueue(subscriber.first, binaryConnections.count(subscriber.first) ? binaryMessage : message);
+    }
+}
+
+void Outbound::removeConnection(websocketpp::connection_hdl hdl)
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    auto it = m_queues.find(hdl);
+    if (it == m_queues.end()) return;
+
+    m_queuedMessages -= it->second.messages.size();
+    m_queuedBytes -= it->second.bytes;
+    m_queues.erase(it);
+}
+
+Object Outbound::getMetricsObject()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    size_t maxQueueMessages = 0;
+    size_t maxQueueBytes = 0;
+    for (auto& item: m_queues)
+    {
+        if (item.second.messages.size() > maxQueueMessages) { maxQueueMessages = item.second.messages.size(); }
+        if (item.second.bytes > maxQueueBytes)              { maxQueueBytes = item.second.bytes; }
+    }
+
+    Object result;
+    result.push_back(Pair("queuedmessages", (uint64_t)m_queuedMessages));
+    result.push_back(Pair("queuedbytes", (uint64_t)m_queuedBytes));
+    result.push_back(Pair("queues", (uint64_t)m_queues.size()));
+    result.push_back(Pair("maxqueuemessages", (uint64_t)maxQueueMessages));
+    result.push_back(Pair("maxqueuebytes", (uint64_t)maxQueueBytes));
+    result.push_back(Pair("dropped", m_droppedMessages));
+    result.push_back(Pair("coalesced", m_coalescedMessages));
+    result.push_back(Pair("evictions", m_evictions));
+    result.push_back(Pair("throttled", m_throttledSends));
+    return result;
+}
+
+// Must be called with m_mutex held.
+void Outbound::enqueue(websocketpp::connection_hdl hdl, const Message& message)
+{
+    if (!m_bRunning) return;
+
+    Queue& queue = m_queues[hdl];
+    queue.messages.push_back(message);
+    queue.bytes += message.payload->size();
+    m_queuedMessages++;
+    m_queuedBytes += message.payload->size();
+
+    if (!enforceLimits(hdl, queue)) return;
+
+    if (!queue.bScheduled)
+    {
+        queue.bScheduled = true;
+        m_ready.push_back(hdl);
+        m_cond.notify_one();
+    }
+}
+
+// Must be called with m_mutex held. Returns false if the connection was evicted.
+bool Outbound::enforceLimits(websocketpp::connection_hdl hdl, Queue& queue)
+{
+    bool bTriedCoalesce = false;
+    while (queue.messages.size() > m_maxMessages || queue.bytes > m_maxBytes)
+    {
+        if (m_policy == DISCONNECT)
+        {
+            if (!queue.bClose) { evict(hdl, queue); }
+            return false;
+        }
+
+        auto it = queue.messages.end();
+        if (m_policy == COALESCE && !bTriedCoalesce)
+        {
+            // The newest message supersedes an older one with the same key.
+            bTriedCoalesce = true;
+            const string& key = queue.messages.back().key;
+            if (!key.empty())
+            {
+                for (it = queue.messages.begin(); it + 1 != queue.messages.end() && it->key != key; ++it);
+                if (it + 1 == queue.messages.end()) { it = queue.messages.end(); }
+                else                                { m_coalescedMessages++; }
+            }
+        }
+
+        if (it == queue.messages.end())
+        {
+            for (it = queue.messages.begin(); it != queue.messages.end() && !it->bDroppable; ++it);
+            if (it == queue.messages.end()) break; // nothing left that may be dropped
+            m_droppedMessages++;
+        }
+
+        queue.bytes -= it->payload->size();
+        m_queuedMessages--;
+        m_queuedBytes -= it->payload->size();
+        queue.messages.erase(it);
+    }
+
+    return true;
+}
+
+// Must be called with m_mutex held.
+void Outbound::evict(websocketpp::connection_hdl hdl, Queue& queue)
+{
+    LOGGER(info) << "Evicting slow client " << hdl.lock().get() << " - outbound queue full." << endl;
+    m_evictions++;
+
+    unsubscribeAll(hdl);
+
+    deque<Message> messages;
+    for (auto& message: queue.messages)
+    {
+        if (!message.bDroppable)
+        {
+            messages.push_back(message);
+            continue;
+        }
+        m_droppedMessages++;
+        queue.bytes -= message.payload->size();
+        m_queuedMessages--;
+        m_queuedBytes -= message.payload->size();
+    }
+    queue.messages.swap(messages);
+
+    queue.messages.push_back(Message(EVICTED_MESSAGE, string(), false));
+    queue.bytes += EVICTED_MESSAGE->size();
+    m_queuedMessages++;
+    m_queuedBytes += EVICTED_MESSAGE->size();
+    queue.bClose = true;
+
+    if (!queue.bScheduled)
+    {
+        queue.bScheduled = true;
+        m_ready.push_back(hdl);
+        m_cond.notify_one();
+    }
+}
+
+void Outbound::run()
+{
+    vector<Message> messages;
+    chrono::steady_clock::time_point retryTime;
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        if (!m_throttled.empty())
+        {
+            // Give throttled connections time to drain before trying them again.
+            if (!m_cond.wait_until(lock, retryTime, [this]() { return !m_bRunning || !m_ready.empty(); }) || chrono::steady_clock::now() >= retryTime)
+            {
+                m_ready.insert(m_ready.end(), m_throttled.begin(), m_throttled.end());
+                m_throttled.clear();
+            }
+        }
+        else
+        {
+            m_cond.wait(lock, [this]() { return !m_bRunning || !m_ready.empty(); });
+        }
+        if (!m_bRunning) break;
+
+        websocketpp::connection_hdl hdl = m_ready.front();
+        m_ready.pop_front();
+
+        auto it = m_queues.find(hdl);
+        if (it == m_queues.end()) continue;
+
+        // A connection being closed gets its last messages regardless.
+        Queue& queue = it->second;
+        size_t bytes = queue.bClose ? 0 : getBufferedAmount(hdl);
+        if (bytes >= m_maxBytes)
+        {
+            if (m_throttled.empty()) { retryTime = chrono::steady_clock::now() + chrono::milliseconds(OUTBOUND_THROTTLE_RETRY_MS); }
+            m_throttledSends++;
+            m_throttled.push_back(hdl);
+            continue;
+        }
+
+        while (!queue.messages.empty() && messages.size() < OUTBOUND_SEND_BATCH && (queue.bClose || bytes < m_maxBytes))
+        {
+            Message& message = queue.messages.front();
+            bytes += message.payload->size();
+            queue.bytes -= message.payload->size();
+            m_queuedMessages--;
+            m_queuedBytes -= message.payload->size();
+            messages.push_back(move(message));
+            queue.messages.pop_front();
+        }
+
+        bool bClose = queue.bClose && queue.messages.empty();
+        if (queue.messages.empty())     { m_queues.erase(it); }
+        else                            { m_ready.push_back(hdl); }
+
+        lock.unlock();
+        for (auto& message: messages)
+        {
+            try
+            {
+                bool bBinary = message.bBinary;
+                payload_ptr encoded = getCompressor().encode(hdl, message.payload, bBinary);
+                if (!encoded)
+                {
+                    closeConnection(hdl, "compression failed");
+                    break;
+                }
+
+                if (bBinary)    { sendBinary(hdl, *encoded); }
+                else            { m_server->send(hdl, *encoded); }
+            }
+            catch (const exception& e)
+            {
+                LOGGER(error) << "Outbound send error: " << e.what() << endl;
+            }
+        }
+        messages.clear();
+
+        if (bClose)
+        {
+            LOGGER(info) << "Closing evicted client " << hdl.lock().get() << "." << endl;
+            closeConnection(hdl, "outbound queue full");
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// outbound.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include "filter.h"
+
+#include <json_spirit/json_spirit_value.h>
+#include <WebSocketAPI/Server.h>
+
+#include <string>
+#include <memory>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// What to do with a connection whose outbound queue is full.
+enum OverflowPolicy
+{
+    DROP_OLDEST,    // discard the oldest queued events
+    COALESCE,       // replace a queued event with the same key, else drop oldest
+    DISCONNECT      // drop all subscriptions and queued events, then close the connection
+};
+
+bool getOverflowPolicy(const std::string& name, OverflowPolicy& policy);
+
+// Messages are immutable once queued so one buffer can be shared by every
+// connection it is sent to.
+typedef std::shared_ptr<const std::string> payload_ptr;
+
+// Per-connection outbound message queues drained by a sender thread. Every
+// message to a client goes through here so responses and events for a given
+// connection stay in order. Events may be dropped or coalesced when a queue
+// exceeds its limits; responses never are. A connection is not sent more
+// while the websocket library still buffers the byte limit for it, so a slow
+// client's messages wait here, where the limits apply.
+class Outbound
+{
+public:
+    Outbound();
+    ~Outbound() { stop(); }
+
+    void start(WebSocket::Server& server, size_t maxMessages, size_t maxBytes, OverflowPolicy policy);
+    void stop();
+
+    // Responses and other messages that must be delivered. Binary payloads
+    // are sent as binary frames, everything else as text.
+    void send(websocketpp::connection_hdl hdl, std::string msg);
+    void send(websocketpp::connection_hdl hdl, const payload_ptr& payload, bool bBinary = false);
+
+    // Events. Queued events with the same nonempty key may be coalesced.
+    void sendEvent(websocketpp::connection_hdl hdl, std::string msg, const std::string& key = std::string());
+    void sendEvent(websocketpp::connection_hdl hdl, const payload_ptr& payload, const std::string& key = std::string(), bool bBinary = false);
+    void sendChannel(const std::string& channel, std::string msg, const std::string& key = std::string());
+    // Subscribers whose filter rejects the tx attributes are skipped. Those
+    // using a binary encoding get binaryPayload, in a binary frame, when
+    // there is one.
+    void sendChannel(const std::string& channel, const payload_ptr& payload, const std::string& key = std::string(), const TxAttributes* attributes = nullptr, const payload_ptr& binaryPayload = payload_ptr());
+
+    void removeConnection(websocketpp::connection_hdl hdl);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    struct Message
+    {
+        Message(const payload_ptr& payload_, const std::string& key_, bool bDroppable_, bool bBinary_ = false)
+            : payload(payload_), key(key_), bDroppable(bDroppable_), bBinary(bBinary_) { }
+
+        payload_ptr payload;
+        std::string key;
+        bool bDroppable;
+        bool bBinary;
+    };
+
+    struct Queue
+    {
+        Queue() : bytes(0), bScheduled(false), bClose(false) { }
+
+        std::deque<Message> messages;
+        size_t bytes;
+        bool bScheduled;
+        bool bClose;    // close the connection once the queue is sent
+    };
+
+    typedef std::map<websocketpp::connection_hdl, Queue, std::owner_less<websocketpp::connection_hdl>> queue_map_t;
+
+    WebSocket::Server* m_server;
+    size_t m_maxMessages;
+    size_t m_maxBytes;
+    OverflowPolicy m_policy;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_bRunning;
+    std::thread m_thread;
+
+    queue_map_t m_queues;
+    std::deque<websocketpp::connection_hdl> m_ready;
+    std::deque<websocketpp::connection_hdl> m_throttled;
+
+    size_t m_queuedMessages;
+    size_t m_queuedBytes;
+    uint64_t m_droppedMessages;
+    uint64_t m_coalescedMessages;
+    uint64_t m_evictions;
+    uint64_t m_throttledSends;
+
+    void enqueue(websocketpp::connection_hdl hdl, const Message& message);
+    bool enforceLimits(websocketpp::connection_hdl hdl, Queue& queue);
+    void evict(websocketpp::connection_hdl hdl, Queue& queue);
+    void run();
+};
+
+Outbound& getOutbound();
+
+}
@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// ratelimit.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "ratelimit.h"
+
+#include <cstdlib>
+
+using namespace CoinSocket;
+using namespace std;
+
+static RateLimiter g_rateLimiter;
+
+RateLimiter& CoinSocket::getRateLimiter()
+{
+    return g_rateLimiter;
+}
+
+static bool parseRate(const string& str, double& value)
+{
+    if (str.empty()) return false;
+
+    char* end;
+    value = strtod(str.c_str(), &end);
+    return *end == '\0' && value >= 0;
+}
+
+bool CoinSocket::getMethodRateLimit(const string& str, string& method, RateLimit& limit)
+{
+    size_t pos = str.find(':');
+    if (pos == string::npos || pos == 0) return false;
+
+    method = str.substr(0, pos);
+    string rateStr = str.substr(pos + 1);
+    string burstStr;
+
+    pos = rateStr.find(':');
+    if (pos != string::npos)
+    {
+        burstStr = rateStr.substr(pos + 1);
+        rateStr = rateStr.substr(0, pos);
+    }
+
+    double rate;
+    double burst = 0;
+    if (!parseRate(rateStr, rate) || rate == 0) return false;
+    if (!burstStr.empty() && !parseRate(burstStr, burst)) return false;
+
+    limit = RateLimit(rate, burst);
+    return true;
+}
+
+TokenBucket::TokenBucket(const RateLimit& limit)
+    : m_limit(limit), m_tokens(limit.burst), m_last(chrono::steady_clock::now())
+{
+}
+
+bool TokenBucket::canConsume(chrono::steady_clock::time_point now, double tokens)
+{
+    if (m_limit.rate == 0) return true;
+
+    double elapsed = chrono::duration<double>(now - m_last).count();
+    m_last = now;
+    m_tokens += elapsed * m_limit.rate;
+    if (m_tokens > m_limit.burst) { m_tokens = m_limit.burst; }
+
+    return m_tokens >= (tokens < m_limit.burst ? tokens : m_limit.burst);
+}
+
+void RateLimiter::setLimits(const RateLimit& connectionLimit, const MethodRateLimits& methodLimits)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_connectionLimit = connectionLimit;
+    m_methodLimits = methodLimits;
+    m_buckets.clear();
+}
+
+bool RateLimiter::admit(websocketpp::connection_hdl hdl, const vector<string>& methods)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_connectionLimit.rate == 0 && m_methodLimits.empty()) return true;
+
+    auto it = m_buckets.find(hdl);
+    if (it == m_buckets.end()) { it = m_buckets.insert(make_pair(hdl, Buckets(m_connectionLimit))).first; }
+    Buckets& buckets = it->second;
+
+    auto now = chrono::steady_clock::now();
+    if (!buckets.connection.canConsume(now, methods.size()))
+    {
+        m_limited++;
+        return false;
+    }
+
+    map<string, double> counts;
+    for (auto& method: methods)
+    {
+        if (m_methodLimits.count(method)) { counts[method]++; }
+    }
+
+    vector<TokenBucket*> methodBuckets;
+    for (auto& count: counts)
+    {
+        auto bucketIt = buckets.methods.find(count.first);
+        if (bucketIt == buckets.methods.end()) { bucketIt = buckets.methods.insert(make_pair(count.first, TokenBucket(m_methodLimits[count.first]))).first; }
+        if (!bucketIt->second.canConsume(now, count.second))
+        {
+            m_limited++;
+            return false;
+        }
+        methodBuckets.push_back(&bucketIt->second);
+    }
+
+    buckets.connection.consume(methods.size());
+    size_t i = 0;
+    for (auto& count: counts) { methodBuckets[i++]->consume(count.second); }
+    return true;
+}
+
+void RateLimiter::removeConnection(websocketpp::connection_hdl hdl)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_buckets.erase(hdl);
+}
+
+uint64_t RateLimiter::getLimitedCount()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_limited;
+}
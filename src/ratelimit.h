@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// ratelimit.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <WebSocketAPI/Server.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Requests per second and the number of requests that may be made at once.
+// A rate of zero means unlimited.
+struct RateLimit
+{
+    RateLimit() : rate(0), burst(0) { }
+    RateLimit(double rate_, double burst_) : rate(rate_), burst(burst_ > 0 ? burst_ : (rate_ > 1 ? rate_ : 1)) { }
+
+    double rate;
+    double burst;
+};
+
+typedef std::map<std::string, RateLimit> MethodRateLimits;
+
+// Parses method:rate[:burst].
+bool getMethodRateLimit(const std::string& str, std::string& method, RateLimit& limit);
+
+class TokenBucket
+{
+public:
+    explicit TokenBucket(const RateLimit& limit);
+
+    // More tokens than the burst may be taken from a full bucket. The
+    // bucket then goes into debt and refills from below zero, so large
+    // batches still run and are still metered at the rate.
+    bool canConsume(std::chrono::steady_clock::time_point now, double tokens);
+    void consume(double tokens) { m_tokens -= tokens; }
+
+private:
+    RateLimit m_limit;
+    double m_tokens;
+    std::chrono::steady_clock::time_point m_last;
+};
+
+// Token buckets for each connection and for each method a connection calls.
+class RateLimiter
+{
+public:
+    RateLimiter() : m_limited(0) { }
+
+    void setLimits(const RateLimit& connectionLimit, const MethodRateLimits& methodLimits);
+
+    // Admits all of the methods or none of them.
+    bool admit(websocketpp::connection_hdl hdl, const std::vector<std::string>& methods);
+
+    void removeConnection(websocketpp::connection_hdl hdl);
+
+    uint64_t getLimitedCount();
+
+private:
+    struct Buckets
+    {
+        explicit Buckets(const RateLimit& limit) : connection(limit) { }
+
+        TokenBucket connection;
+        std::map<std::string, TokenBucket> methods;
+    };
+
+    typedef std::map<websocketpp::connection_hdl, Buckets, std::owner_less<websocketpp::connection_hdl>> bucket_map_t;
+
+    std::mutex m_mutex;
+    RateLimit m_connectionLimit;
+    MethodRateLimits m_methodLimits;
+    bucket_map_t m_buckets;
+    uint64_t m_limited;
+};
+
+RateLimiter& getRateLimiter();
+
+}
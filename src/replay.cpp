@@ -0,0 +1,193 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// replay.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "replay.h"
+#include "outbound.h"
+#include "encoding.h"
+
+#include <json_spirit/json_spirit_writer_template.h>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <chrono>
+
+using namespace CoinSocket;
+using namespace json_spirit;
+using namespace std;
+
+struct ReplayEvent
+{
+    uint64_t seq;
+    string channel;
+    payload_ptr payload;
+    payload_ptr binaryPayload;
+    tx_attributes_ptr attributes;
+};
+
+// Sequence numbers are not persisted, so each run starts numbering from the
+// time it started in microseconds. Numbers a client kept from an earlier run
+// are then below anything this run has published and its resume is refused.
+static uint64_t getInitialSequence()
+{
+    return chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Publishing, and subscribing with replay, both hold this lock so a resuming
+// client sees replayed and live events in sequence order with no gaps.
+static mutex g_replayMutex;
+static deque<ReplayEvent> g_replayRing;
+static size_t g_replayCapacity = 0;
+static uint64_t g_lastSeq = getInitialSequence();
+// The last sequence number issued before an event on the channel was skipped
+// for lack of subscribers.
+static map<string, uint64_t> g_channelGaps;
+static uint64_t g_replays = 0;
+static uint64_t g_replayMisses = 0;
+
+void CoinSocket::setReplayCapacity(size_t capacity, uint32_t retainSeconds)
+{
+    lock_guard<mutex> lock(g_replayMutex);
+    g_replayCapacity = capacity;
+    while (g_replayRing.size() > g_replayCapacity) { g_replayRing.pop_front(); }
+
+    setRetainChannels(capacity > 0 ? retainSeconds : 0);
+}
+
+bool CoinSocket::isReplayEnabled()
+{
+    lock_guard<mutex> lock(g_replayMutex);
+    return g_replayCapacity > 0;
+}
+
+bool CoinSocket::isChannelLive(const string& channel)
+{
+    if (hasSubscribers(channel)) return true;
+
+    // Checked again under the lock in case a resume subscribed in between,
+    // in which case the event must be rendered after all.
+    lock_guard<mutex> lock(g_replayMutex);
+    if (hasSubscribers(channel)) return true;
+
+    g_channelGaps[channel] = g_lastSeq;
+    return false;
+}
+
+// dataCbor is empty unless some connection uses the binary encoding.
+static void publish(const string& channel, const string& dataJson, const string& dataCbor, const string& key, tx_attributes_ptr attributes)
+{
+    lock_guard<mutex> lock(g_replayMutex);
+    uint64_t seq = ++g_lastSeq;
+
+    string msg("{\"event\":\"");
+    msg += channel;
+    msg += "\", \"seq\":";
+    msg += to_string(seq);
+    msg += ", \"data\":";
+    msg += dataJson;
+    msg += "}";
+    payload_ptr payload = make_shared<const string>(move(msg));
+    payload_ptr binaryPayload;
+    if (!dataCbor.empty()) { binaryPayload = makeCborEventPayload(channel, seq, dataCbor); }
+
+    if (g_replayCapacity > 0)
+    {
+        if (g_replayRing.size() >= g_replayCapacity) { g_replayRing.pop_front(); }
+        ReplayEvent event;
+        event.seq = seq;
+        event.channel = channel;
+        event.payload = payload;
+        event.binaryPayload = binaryPayload;
+        event.attributes = attributes;
+        g_replayRing.push_back(event);
+    }
+
+    getOutbound().sendChannel(channel, payload, key, attributes.get(), binaryPayload);
+}
+
+void CoinSocket::publishChannelEvent(const string& channel, const Value& data, const string& key, tx_attributes_ptr attributes)
+{
+    if (!isChannelLive(channel)) return;
+
+    // Rendered outside the lock - publish only adds the envelope.
+    string dataCbor;
+    if (hasBinaryConnections()) { appendCbor(dataCbor, data); }
+    publish(channel, write_string<Value>(data), dataCbor, key, attributes);
+}
+
+void CoinSocket::publishChannelEventJson(const string& channel, const string& dataJson, const string& key, tx_attributes_ptr attributes)
+{
+    if (!isChannelLive(channel)) return;
+
+    publish(channel, dataJson, string(), key, attributes);
+}
+
+bool CoinSocket::subscribeFromSequence(websocketpp::connection_hdl hdl, const Channels& channels, uint64_t seq, filter_ptr filter)
+{
+    lock_guard<mutex> lock(g_replayMutex);
+    for (auto& channel: channels) { subscribe(hdl, channel, filter); }
+
+    // A number beyond the last one was not issued by this run.
+    if (seq > g_lastSeq)
+    {
+        g_replayMisses++;
+        return false;
+    }
+
+    for (auto& channel: channels)
+    {
+        auto it = g_channelGaps.find(channel);
+        if (it != g_channelGaps.end() && it->second >= seq)
+        {
+            g_replayMisses++;
+            return false;
+        }
+    }
+    if (seq == g_lastSeq) return true;
+
+    // Events with sequence numbers from seq + 1 onward must all still be held.
+    if (g_replayRing.empty() || g_replayRing.front().seq > seq + 1)
+    {
+        g_replayMisses++;
+        return false;
+    }
+
+    g_replays++;
+    bool bBinary = getConnectionEncoding(hdl) == ENCODING_CBOR;
+    for (auto& event: g_replayRing)
+    {
+        if (event.seq <= seq || !channels.count(event.channel)) continue;
+        if (isTxChannel(event.channel) && !filterMatches(filter, event.attributes.get())) continue;
+        if (bBinary && event.binaryPayload)  { getOutbound().sendEvent(hdl, event.binaryPayload, string(), true); }
+        else                                 { getOutbound().sendEvent(hdl, event.payload); }
+    }
+    return true;
+}
+
+uint64_t CoinSocket::getLastSequence()
+{
+    lock_guard<mutex> lock(g_replayMutex);
+    return g_lastSeq;
+}
+
+Object CoinSocket::getReplayMetricsObject()
+{
+    lock_guard<mutex> lock(g_replayMutex);
+
+    Object result;
+    result.push_back(Pair("lastseq", g_lastSeq));
+    result.push_back(Pair("ringsize", (uint64_t)g_replayRing.size()));
+    result.push_back(Pair("oldestseq", g_replayRing.empty() ? (uint64_t)0 : g_replayRing.front().seq));
+    result.push_back(Pair("replays", g_replays));
+    result.push_back(Pair("misses", g_replayMisses));
+    return result;
+}
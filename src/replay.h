@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// replay.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include "channels.h"
+
+#include <json_spirit/json_spirit_value.h>
+#include <WebSocketAPI/Server.h>
+
+#include <string>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Every channel event is numbered from a single sequence and the most recent
+// ones are kept so a reconnecting client can pick up where it left off.
+// Channels stay rendered for retainSeconds after their last subscriber
+// leaves, so it has that long to come back.
+void setReplayCapacity(size_t capacity, uint32_t retainSeconds);
+bool isReplayEnabled();
+
+// False if nobody would see an event on the channel, so it need not be
+// rendered. The event is then noted as missing from the ring and a resume
+// from before it is refused.
+bool isChannelLive(const std::string& channel);
+
+// Sends {"event":channel, "seq":n, "data":data} to the channel's subscribers.
+// Tx events pass their attributes so subscription filters can be applied.
+// Events published from a value also go out in CBOR to connections that use
+// it; preformatted JSON events are sent to everyone as JSON.
+void publishChannelEvent(const std::string& channel, const json_spirit::Value& data, const std::string& key = std::string(), tx_attributes_ptr attributes = tx_attributes_ptr());
+void publishChannelEventJson(const std::string& channel, const std::string& dataJson, const std::string& key = std::string(), tx_attributes_ptr attributes = tx_attributes_ptr());
+
+// Subscribes the connection and sends it every retained event on those
+// channels with a sequence number after seq. Returns false if events after
+// seq have already been dropped from the ring or were never rendered, or seq
+// was not issued by this run of the server, in which case the client must
+// resynchronize. Replayed tx events are filtered like live ones, and are sent
+// in the connection's encoding if they were rendered in it.
+bool subscribeFromSequence(websocketpp::connection_hdl hdl, const Channels& channels, uint64_t seq, filter_ptr filter = filter_ptr());
+
+uint64_t getLastSequence();
+
+json_spirit::Object getReplayMetricsObject();
+
+}
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// txjsoncache.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "txjsoncache.h"
+#include "jsonobjects.h"
+
+using namespace CoinSocket;
+using namespace CoinDB;
+using namespace json_spirit;
+using namespace std;
+
+void TxJsonCache::setMaxSize(size_t maxSize)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_maxSize = maxSize;
+    while (m_entries.size() > m_maxSize)
+    {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+TxJsonCache::fragment_ptr TxJsonCache::getTxMembers(const Tx& tx)
+{
+    Key key;
+    key.unsignedHash = tx.unsigned_hash();
+    key.hash = tx.hash();
+    key.status = (int)tx.status();
+    key.height = tx.blockheader() ? tx.blockheader()->height() : 0;
+    for (auto& txout: tx.txouts())
+    {
+        key.labels += txout->sending_label();
+        key.labels += '\0';
+        key.labels += txout->receiving_label();
+        key.labels += '\0';
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end())
+        {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            m_hits++;
+            return it->second->second;
+        }
+        m_misses++;
+    }
+
+    // Rendered outside the lock. A concurrent miss on the same tx just
+    // renders it twice.
+    JsonWriter writer;
+    writer.beginObject();
+    writeTxMembers(writer, tx);
+    writer.endObject();
+
+    const string& json = writer.str();
+    fragment_ptr fragment(new string(json, 1, json.size() - 2));
+
+    lock_guard<mutex> lock(m_mutex);
+    if (m_maxSize == 0 || m_index.count(key)) return fragment;
+
+    m_entries.push_front(make_pair(key, fragment));
+    m_index[key] = m_entries.begin();
+    if (m_entries.size() > m_maxSize)
+    {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+    return fragment;
+}
+
+void TxJsonCache::invalidate(const bytes_t& unsignedHash)
+{
+    Key first;
+    first.unsignedHash = unsignedHash;
+    first.status = 0;
+    first.height = 0;
+
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_index.lower_bound(first);
+    while (it != m_index.end() && it->first.unsignedHash == unsignedHash)
+    {
+        m_entries.erase(it->second);
+        it = m_index.erase(it);
+    }
+}
+
+Object TxJsonCache::getMetricsObject()
+{
+    lock_guard<mutex> lock(m_mutex);
+
+    Object result;
+    result.push_back(Pair("size", (uint64_t)m_entries.size()));
+    result.push_back(Pair("hits", m_hits));
+    result.push_back(Pair("misses", m_misses));
+    return result;
+}
+
+TxJsonCache& CoinSocket::getTxJsonCache()
+{
+    static TxJsonCache txJsonCache;
+    return txJsonCache;
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// txjsoncache.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include <CoinDB/Schema.h>
+
+#include <json_spirit/json_spirit_value.h>
+
+#include <string>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace CoinSocket
+{
+
+// Tx JSON members as writeTxMembers renders them, so a tx sent to several
+// channels and connections is rendered once. Entries are keyed by unsigned
+// hash, since unsigned txs have no hash yet, then by hash, status, height and
+// the txout labels, which is everything rendered that can change, so an entry
+// can never be served for a different state of the tx whichever thread
+// rendered it. Entries for a tx are dropped by unsigned hash when the vault
+// updates or deletes it, and the least recently used entries are evicted once
+// the cache is full.
+class TxJsonCache
+{
+public:
+    typedef std::shared_ptr<const std::string> fragment_ptr;
+
+    TxJsonCache() : m_maxSize(0), m_hits(0), m_misses(0) { }
+
+    // Zero disables caching.
+    void setMaxSize(size_t maxSize);
+
+    fragment_ptr getTxMembers(const CoinDB::Tx& tx);
+    void invalidate(const bytes_t& unsignedHash);
+
+    json_spirit::Object getMetricsObject();
+
+private:
+    struct Key
+    {
+        bytes_t unsignedHash;
+        bytes_t hash;
+        int status;
+        uint32_t height;
+        std::string labels;
+
+        bool operator<(const Key& rhs) const
+        {
+            if (unsignedHash != rhs.unsignedHash)   return unsignedHash < rhs.unsignedHash;
+            if (hash != rhs.hash)                   return hash < rhs.hash;
+            if (status != rhs.status)               return status < rhs.status;
+            if (height != rhs.height)               return height < rhs.height;
+            return labels < rhs.labels;
+        }
+    };
+
+    typedef std::list<std::pair<Key, fragment_ptr>> entry_list_t;
+
+    std::mutex m_mutex;
+    size_t m_maxSize;
+    entry_list_t m_entries;
+    std::map<Key, entry_list_t::iterator> m_index;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+
+TxJsonCache& getTxJsonCache();
+
+}
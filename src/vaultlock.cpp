@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// vaultlock.cpp
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#include "vaultlock.h"
+
+using namespace CoinSocket;
+using namespace std;
+
+static boost::shared_mutex g_vaultMutex;
+static thread_local VaultLock* g_currentVaultLock = nullptr;
+
+VaultLock::VaultLock(Command::access_t access, bool bReleasable)
+    : m_sharedLock(g_vaultMutex, boost::defer_lock), m_uniqueLock(g_vaultMutex, boost::defer_lock), m_bReleasable(bReleasable), m_parent(g_currentVaultLock)
+{
+    switch (access)
+    {
+    case Command::NO_VAULT:     break;
+    case Command::READ_ONLY:    m_sharedLock.lock(); break;
+    case Command::MUTATING:     m_uniqueLock.lock(); break;
+    }
+    g_currentVaultLock = this;
+}
+
+VaultLock::~VaultLock()
+{
+    g_currentVaultLock = m_parent;
+}
+
+void VaultLock::release()
+{
+    if (!m_bReleasable) return;
+    if (m_sharedLock.owns_lock()) { m_sharedLock.unlock(); }
+    if (m_uniqueLock.owns_lock()) { m_uniqueLock.unlock(); }
+}
+
+void CoinSocket::releaseVaultLock()
+{
+    if (g_currentVaultLock) { g_currentVaultLock->release(); }
+}
@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CoinSocket
+//
+// vaultlock.h
+//
+// Copyright (c) 2016 Ciphrex Corp.
+//
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+//
+
+#pragma once
+
+#include "commands.h"
+
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+namespace CoinSocket
+{
+
+// Holds the vault lock a command needs for the lifetime of the scope: none
+// for commands that never touch the vault, shared for read-only commands and
+// exclusive for mutating commands.
+class VaultLock
+{
+public:
+    // A releasable lock may be given up early by the command holding it.
+    // Batches and idempotent commands need theirs until they are done.
+    VaultLock(Command::access_t access, bool bReleasable = true);
+    ~VaultLock();
+
+    void release();
+
+private:
+    boost::shared_lock<boost::shared_mutex> m_sharedLock;
+    boost::unique_lock<boost::shared_mutex> m_uniqueLock;
+    bool m_bReleasable;
+    VaultLock* m_parent;
+};
+
+// Called by mutating command handlers once the vault has been changed and
+// only a sync or rescan remains, which SynchedVault serializes itself. Other
+// commands can then run while it completes. Does nothing unless the calling
+// thread holds a releasable vault lock.
+void releaseVaultLock();
+
+}